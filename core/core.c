@@ -5,6 +5,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <zlib.h>
+#ifndef SF2000
+#include <SDL_thread.h>
+#include <SDL_cpuinfo.h>
+#endif
 
 // large enough for TT high resolution 1280x960 at 32bpp
 #define VIDEO_MAX_W   2048
@@ -12,6 +17,8 @@
 #define VIDEO_MAX_PITCH   (VIDEO_MAX_W*4)
 // 4 frames of buffer at slowest framerate
 #define AUDIO_BUFFER_LEN   (4*2*96000/50)
+// contiguous pieces of audio sent per frame
+#define AUDIO_SPANS_MAX   16
 
 // Header size must accomodate core data before the hatari memory snapshot
 // the base savesate for a 1MB ST is about 3.5MB
@@ -21,10 +28,21 @@
 // The overhead is added to the initial estimate just in case it's not quite enough,
 // and the rounding makes the file size into a round number.
 #define SNAPSHOT_HEADER_SIZE   1024
-#define SNAPSHOT_MINIMUM       (8 * 1024 * 1024)
-#define SNAPSHOT_OVERHEAD      (1 * 1024 * 1024)
+#define SNAPSHOT_OVERHEAD      (256 * 1024) // IPF raw tracks and STX writes have no fixed maximum
 #define SNAPSHOT_ROUND         (64 * 1024)
-#define SNAPSHOT_VERSION       2
+#define SNAPSHOT_VERSION       3
+
+// Compressed savestate container, distinguished from a raw savestate by its first word (raw begins with SNAPSHOT_VERSION).
+// Header: magic, raw length, block size, block count, then a table of compressed block lengths, then the blocks.
+// Each block is an independent zlib stream, so they are (de)compressed in parallel.
+#define SNAPSHOT_COMPRESS_MAGIC    0x315A4248UL // "HBZ1"
+#define SNAPSHOT_COMPRESS_BLOCK    (256 * 1024)
+#define SNAPSHOT_COMPRESS_LEVEL    1
+#ifndef SF2000
+#define SNAPSHOT_COMPRESS_THREADS  4 // including the calling thread, at most one per CPU
+#else
+#define SNAPSHOT_COMPRESS_THREADS  1
+#endif
 
 // Logs seem valid for either first retro_set_environment or everything else,
 // set this to 1 when you want to log the first call to retro_set_environment.
@@ -66,6 +84,11 @@ const uint64_t QUIRKS = RETRO_SERIALIZATION_QUIRK_ENDIAN_DEPENDENT;
 // because it causes bContentsChanged divergence for any floppies that have save files.
 // (if DEBUG=1 in the make file, CORE_DEBUG will automatically enable LIBRETRO_DEBUG_SNAPSHOT)
 
+// Uncomment to benchmark savestates X frames after starting the core content, simulating run-ahead
+// (save, hidden frame, restore) for 100 frames with complete savestates, then 100 with incremental ones,
+// and logs the average microseconds to save and restore each. Repeat with each ST RAM size to compare.
+//#define DEBUG_SAVESTATE_BENCHMARK   300
+
 #define DEBUG_SAVESTATE   (DEBUG_SAVESTATE_DUMP | DEBUG_SAVESTATE_DUMP_AUTO | DEBUG_SAVESTATE_SIMPLE | DEBUG_SAVESTATE_LIST)
 
 //
@@ -104,6 +127,7 @@ extern int core_save_state(void);
 extern int core_restore_state(void);
 extern void Statusbar_SetMessage(const char *msg);
 extern void core_statusbar_update(void);
+extern void core_screen_enable(bool enable);
 
 //
 // Available to Hatari
@@ -122,6 +146,11 @@ bool core_show_welcome = true;
 bool core_boot_alert = true;
 bool core_first_reset = true;
 bool core_perf_display = false;
+bool core_savestate_delta_enable = true;
+bool core_savestate_delta = false; // current savestate only stores RAM changes (stMemory.c)
+bool core_savestate_local = false; // current savestate is only saved and restored by this instance, modified disks are not embedded (floppy.c), the ROM hash is skipped (stMemory.c)
+int core_rewind_size = 0;
+bool core_savestate_compress = false;
 bool core_midi_enable = true;
 
 // internal
@@ -131,12 +160,22 @@ bool content_override_set = false;
 uint32_t blank_screen[320*200] = { 0 }; // safety buffer in case frame was never been provided
 
 void* core_video_buffer = blank_screen;
-int16_t core_audio_buffer[AUDIO_BUFFER_LEN];
+int16_t core_audio_buffer[AUDIO_BUFFER_LEN] __attribute__((aligned(64))); // hold and silence samples
+const int16_t* core_audio_span_data[AUDIO_SPANS_MAX]; // audio to send at the end of the frame
+int core_audio_span_len[AUDIO_SPANS_MAX];
+int core_audio_spans = 0;
 int16_t core_audio_last[2] = { 0, 0 };
 double core_audio_hold_remain = 0;
 int core_video_w = 320;
 int core_video_h = 200;
 int core_video_pitch = 320 * sizeof(uint32_t);
+bool core_video_dupe = false; // frontend accepts NULL for a repeated frame
+bool core_video_dirty = true; // video buffer changed since it was last sent
+bool core_video_enable = true; // frontend will show this frame
+bool core_audio_enable = true; // frontend will play this frame's audio
+bool core_audio_filter = true; // apply audio output filters
+int core_ff_frameskip = 4; // draw 1 of every N frames while fast-forwarding (1 = all)
+int core_ff_frame = 0;
 int core_video_resolution = 0;
 float core_video_aspect = 1.0;
 int core_video_aspect_mode = 0;
@@ -332,6 +371,7 @@ void core_video_update(void* data, int w, int h, int pitch, int resolution)
 	if (h > VIDEO_MAX_H) w = VIDEO_MAX_H;
 	if (pitch > VIDEO_MAX_PITCH) w = VIDEO_MAX_PITCH;
 	core_video_buffer = data;
+	core_video_dirty = true;
 	if (w != core_video_w) { core_video_w = w; core_video_changed = true; }
 	if (h != core_video_h) { core_video_h = h; core_video_changed = true; }
 	core_video_pitch = pitch;
@@ -343,26 +383,50 @@ void core_video_update(void* data, int w, int h, int pitch, int resolution)
 	}
 }
 
-void core_audio_update(const int16_t data[][2], int index, int length)
+static void core_audio_span(const int16_t* data, int length)
 {
-	int pos = core_audio_samples_pending;
-	int len = length * 2;
-	int max = AUDIO_BUFFER_LEN - pos;
-	if (len > max) len = max;
-	core_audio_samples_pending += len;
-	int l2 = len / 2;
-	for (int i=0; i<l2; ++i)
+	// extend the last span if this continues it
+	int n = core_audio_spans;
+	if (n > 0 && (core_audio_span_data[n-1] + core_audio_span_len[n-1] * 2) == data)
 	{
-		core_audio_buffer[pos+0] = data[index+i][0];
-		core_audio_buffer[pos+1] = data[index+i][1];
-		pos += 2;
+		core_audio_span_len[n-1] += length;
 	}
-	// save last sample in case hold is needed
-	if (l2 > 0)
+	else if (n < AUDIO_SPANS_MAX)
 	{
-		core_audio_last[0] = data[index+l2-1][0];
-		core_audio_last[1] = data[index+l2-1][1];
+		core_audio_span_data[n] = data;
+		core_audio_span_len[n] = length;
+		core_audio_spans = n + 1;
 	}
+	else return;
+	core_audio_samples_pending += length * 2;
+}
+
+static void core_audio_discard(void)
+{
+	core_audio_samples_pending = 0;
+	core_audio_spans = 0;
+}
+
+void core_audio_update(const int16_t data[][2], int index, int length)
+{
+	// data is sent directly at the end of the frame,
+	// AudioMixBuffer holds several frames so it won't be overwritten before then
+	int max = (AUDIO_BUFFER_LEN - core_audio_samples_pending) / 2;
+	if (length > max) length = max;
+	if (length <= 0) return;
+	core_audio_span(data[index], length);
+	// save last sample in case hold is needed
+	core_audio_last[0] = data[index+length-1][0];
+	core_audio_last[1] = data[index+length-1][1];
+}
+
+static void core_audio_silence(void)
+{
+	// replace the pending audio with silence
+	int len = core_audio_samples_pending;
+	memset(core_audio_buffer, 0, sizeof(int16_t) * len);
+	core_audio_discard();
+	core_audio_span(core_audio_buffer, len / 2);
 }
 
 static void core_audio_hold(int length)
@@ -372,14 +436,14 @@ static void core_audio_hold(int length)
 	int len = length * 2;
 	int max = AUDIO_BUFFER_LEN - pos;
 	if (len > max) len = max;
-	core_audio_samples_pending += len;
-	int l2 = len / 2;
-	for (int i=0; i<l2; ++i)
-	{
-		core_audio_buffer[pos+0] = core_audio_last[0];
-		core_audio_buffer[pos+1] = core_audio_last[1];
-		pos += 2;
-	}
+	if (len <= 0) return;
+	// fill by doubling copies of the last sample
+	int16_t* buf = core_audio_buffer + pos;
+	buf[0] = core_audio_last[0];
+	buf[1] = core_audio_last[1];
+	for (int i=2; i<len; i*=2)
+		memcpy(buf+i, buf, sizeof(int16_t) * (((len-i) < i) ? (len-i) : i));
+	core_audio_span(buf, len / 2);
 }
 
 void core_set_fps(int rate)
@@ -648,6 +712,7 @@ int snapshot_pos = 0;
 int snapshot_max = 0;
 int snapshot_size = 0;
 bool snapshot_error = false;
+bool core_snapshot_size_query = false;
 #if DEBUG_SAVESTATE
 #define DEBUG_SNAPSHOT_SECTIONS   64
 static const char* debug_snapshot_section_name[DEBUG_SNAPSHOT_SECTIONS];
@@ -795,6 +860,7 @@ static void snapshot_buffer_prepare(size_t size, void* data)
 
 bool core_serialize_write = false; // serialization direction
 uint32_t core_rand_seed = 1;
+static bool rewind_serialize = false; // rewind keeps its own zero padding
 
 // deterministic savestated replacement for rand()
 int core_rand(void)
@@ -879,7 +945,8 @@ static bool core_serialize(bool write)
 	if (write)
 	{
 		// zero fill the remaining space
-		if (snapshot_buffer && snapshot_max < snapshot_size)
+		// (not needed for incremental or rewind savestates, which never leave this instance)
+		if (snapshot_buffer && snapshot_max < snapshot_size && !core_savestate_delta && !rewind_serialize)
 			memset(snapshot_buffer + snapshot_max, 0, snapshot_size - snapshot_max);
 	}
 	else
@@ -951,6 +1018,279 @@ static bool core_serialize(bool write)
 	return !snapshot_error;
 }
 
+//
+// rewind
+//
+// The most recent frame is kept as a complete savestate (rewind_state),
+// and a ring buffer holds a delta for each frame before it, newest last.
+// A delta is the XOR of two consecutive savestates, stored as runs of 64-bit words:
+//   uint32 previous state length, uint32 run count
+//   per run: uint32 words to skip, uint32 words in run, XOR words
+// Most of a savestate doesn't change from frame to frame, so these are usually small,
+// and stepping back only touches the words that changed.
+// The restore only copies the RAM pages that were written since the last save or
+// restore, or that the delta changed (core_rewind_changed, stMemory.c).
+//
+
+#define REWIND_ENTRIES   (1<<16)
+
+static uint8_t* rewind_buffer = NULL; // ring of deltas
+static uint32_t rewind_buffer_size = 0;
+static uint64_t* rewind_state = NULL; // most recent frame
+static uint64_t* rewind_temp = NULL; // next frame, swapped with rewind_state after encoding
+static uint64_t* rewind_delta = NULL; // encoded delta before it is added to the ring
+static int rewind_state_size = 0; // allocated size of each state buffer (snapshot_size)
+static int rewind_state_len = 0; // used length of rewind_state, 0 if empty
+static int rewind_state_extent = 0; // each state buffer is zero beyond its extent
+static int rewind_temp_extent = 0;
+static int rewind_size_mb = 0;
+static bool rewind_head_used = false; // rewind_state has already been restored, next step needs a delta
+bool core_savestate_rewind = false;
+uint8_t* core_rewind_changed = NULL;
+static int rewind_changed_size = 0;
+static uint32_t rewind_entry_pos[REWIND_ENTRIES];
+static uint32_t rewind_entry_len[REWIND_ENTRIES];
+static int rewind_entry_first = 0; // oldest
+static int rewind_entry_count = 0;
+
+static void core_rewind_free(void)
+{
+	free(rewind_buffer); rewind_buffer = NULL;
+	free(rewind_state); rewind_state = NULL;
+	free(rewind_temp); rewind_temp = NULL;
+	free(rewind_delta); rewind_delta = NULL;
+	free(core_rewind_changed); core_rewind_changed = NULL;
+	rewind_changed_size = 0;
+	rewind_buffer_size = 0;
+	rewind_state_size = 0;
+	rewind_state_len = 0;
+	rewind_state_extent = 0;
+	rewind_temp_extent = 0;
+	rewind_size_mb = 0;
+	rewind_head_used = false;
+	rewind_entry_first = 0;
+	rewind_entry_count = 0;
+}
+
+static bool core_rewind_alloc(void)
+{
+	core_rewind_free();
+	if (core_rewind_size <= 0 || snapshot_size <= 0) return false;
+	rewind_buffer_size = (uint32_t)core_rewind_size * 1024 * 1024;
+	rewind_state_size = snapshot_size;
+	rewind_buffer = malloc(rewind_buffer_size);
+	rewind_state = calloc(1,rewind_state_size);
+	rewind_temp = calloc(1,rewind_state_size);
+	// worst case: header, one run header, every word
+	rewind_delta = malloc(rewind_state_size + 16);
+	rewind_changed_size = (rewind_state_size >> CORE_REWIND_BLOCK_SHIFT) + 1;
+	core_rewind_changed = calloc(1,rewind_changed_size);
+	if (!rewind_buffer || !rewind_state || !rewind_temp || !rewind_delta || !core_rewind_changed)
+	{
+		retro_log(RETRO_LOG_ERROR,"Unable to allocate %d MB rewind buffer.\n",core_rewind_size);
+		core_rewind_free();
+		core_signal_alert("Not enough memory for rewind buffer.");
+		core_rewind_size = 0; // don't try again until the option changes
+		return false;
+	}
+	rewind_size_mb = core_rewind_size;
+	retro_log(RETRO_LOG_INFO,"Rewind buffer: %d MB\n",rewind_size_mb);
+	return true;
+}
+
+static void core_rewind_drop_oldest(void)
+{
+	rewind_entry_first = (rewind_entry_first + 1) % REWIND_ENTRIES;
+	--rewind_entry_count;
+}
+
+static void core_rewind_push_entry(const uint8_t* data, uint32_t len)
+{
+	if (len > rewind_buffer_size) // can't fit, history is lost
+	{
+		rewind_entry_count = 0;
+		return;
+	}
+	if (rewind_entry_count >= REWIND_ENTRIES) core_rewind_drop_oldest();
+	// find space after the newest entry, or wrap around to the start, dropping old entries until it fits
+	uint32_t pos = 0;
+	while (rewind_entry_count > 0)
+	{
+		int newest = (rewind_entry_first + rewind_entry_count - 1) % REWIND_ENTRIES;
+		uint32_t tail = rewind_entry_pos[rewind_entry_first];
+		uint32_t head = rewind_entry_pos[newest] + rewind_entry_len[newest];
+		if (rewind_entry_pos[newest] >= tail) // used space is contiguous: tail to head
+		{
+			if ((rewind_buffer_size - head) >= len) { pos = head; break; }
+			if (tail >= len) { pos = 0; break; }
+		}
+		else // used space wraps: tail to end, start to head
+		{
+			if ((tail - head) >= len) { pos = head; break; }
+		}
+		core_rewind_drop_oldest();
+	}
+	int index = (rewind_entry_first + rewind_entry_count) % REWIND_ENTRIES;
+	rewind_entry_pos[index] = pos;
+	rewind_entry_len[index] = len;
+	++rewind_entry_count;
+	memcpy(rewind_buffer + pos, data, len);
+}
+
+// encodes rewind_state ^ rewind_temp into rewind_delta, returns length in bytes
+static uint32_t core_rewind_encode(int words)
+{
+	const uint64_t* a = rewind_state;
+	const uint64_t* b = rewind_temp;
+	uint32_t* header = (uint32_t*)rewind_delta;
+	uint64_t* out = rewind_delta + 1;
+	uint32_t runs = 0;
+	int i = 0;
+	while (i < words)
+	{
+		int start = i;
+		while (i < words && a[i] == b[i]) ++i;
+		if (i >= words) break;
+		uint32_t* run = (uint32_t*)out;
+		run[0] = (uint32_t)(i - start);
+		uint64_t* x = out + 1;
+		// a single matching word costs as much as a new run, so it stays in this one
+		while (i < words && (a[i] != b[i] || ((i+1) < words && a[i+1] != b[i+1])))
+		{
+			*x++ = a[i] ^ b[i];
+			++i;
+		}
+		run[1] = (uint32_t)((x - out) - 1);
+		out = x;
+		++runs;
+	}
+	header[0] = (uint32_t)rewind_state_len;
+	header[1] = runs;
+	return (uint32_t)((uint8_t*)out - (uint8_t*)rewind_delta);
+}
+
+// applies a delta to rewind_state, making it the previous frame, and marks the blocks it changes
+static void core_rewind_decode(const uint8_t* data)
+{
+	const uint32_t* header = (const uint32_t*)data;
+	const uint64_t* in = (const uint64_t*)data + 1;
+	uint64_t* s = rewind_state;
+	rewind_state_len = (int)header[0];
+	if (rewind_state_len > rewind_state_extent) rewind_state_extent = rewind_state_len;
+	for (uint32_t r = 0; r < header[1]; ++r)
+	{
+		const uint32_t* run = (const uint32_t*)in;
+		s += run[0];
+		uint32_t count = run[1];
+		++in;
+		size_t first = (size_t)(s - rewind_state) * 8;
+		memset(core_rewind_changed + (first >> CORE_REWIND_BLOCK_SHIFT), 1,
+			((first + count * 8 - 1) >> CORE_REWIND_BLOCK_SHIFT) - (first >> CORE_REWIND_BLOCK_SHIFT) + 1);
+		for (uint32_t k = 0; k < count; ++k) s[k] ^= in[k];
+		s += count;
+		in += count;
+	}
+}
+
+static void core_rewind_push(void)
+{
+	// save the new frame into rewind_temp, keeping it zero padded
+	snapshot_buffer_prepare(rewind_state_size,rewind_temp);
+	rewind_serialize = true;
+	core_savestate_local = true;
+	core_savestate_rewind = true;
+	bool result = core_serialize(true);
+	core_savestate_rewind = false;
+	core_savestate_local = false;
+	rewind_serialize = false;
+	memset(core_rewind_changed, 0, rewind_changed_size);
+	int len = snapshot_max;
+	if (len > rewind_state_size) len = rewind_state_size;
+	if (len < rewind_temp_extent) memset((uint8_t*)rewind_temp + len, 0, rewind_temp_extent - len);
+	rewind_temp_extent = len;
+	if (!result)
+	{
+		rewind_state_len = 0;
+		rewind_entry_count = 0;
+		return;
+	}
+
+	// store the delta to the previous frame
+	if (rewind_state_len > 0)
+	{
+		int words = ((len > rewind_state_len) ? len : rewind_state_len);
+		words = (words + 7) / 8;
+		uint32_t delta_len = core_rewind_encode(words);
+		core_rewind_push_entry((const uint8_t*)rewind_delta, delta_len);
+	}
+
+	// the new frame becomes the head
+	uint64_t* swap = rewind_state;
+	int swap_extent = rewind_state_extent;
+	rewind_state = rewind_temp;
+	rewind_state_extent = rewind_temp_extent;
+	rewind_state_len = len;
+	rewind_temp = swap;
+	rewind_temp_extent = swap_extent;
+	rewind_head_used = false;
+}
+
+static bool core_rewind_step(void)
+{
+	if (rewind_state_len <= 0) return false;
+	// the first step goes back to the start of the last frame, which is the head itself
+	if (rewind_head_used && rewind_entry_count > 0)
+	{
+		int newest = (rewind_entry_first + rewind_entry_count - 1) % REWIND_ENTRIES;
+		core_rewind_decode(rewind_buffer + rewind_entry_pos[newest]);
+		--rewind_entry_count;
+	}
+	// else: stay on the oldest frame
+	rewind_head_used = true;
+
+	// restore without the floppy safety save, which would happen every frame
+	bool floppy_modify = core_savestate_floppy_modify;
+	core_savestate_floppy_modify = false;
+	snapshot_buffer_prepare(rewind_state_size,rewind_state);
+	core_savestate_local = true;
+	core_savestate_rewind = true;
+	bool result = core_serialize(false);
+	core_savestate_rewind = false;
+	core_savestate_local = false;
+	core_savestate_floppy_modify = floppy_modify;
+	memset(core_rewind_changed, 0, rewind_changed_size);
+	if (!result)
+	{
+		retro_log(RETRO_LOG_ERROR,"Rewind restore failed.\n");
+		rewind_state_len = 0;
+		rewind_entry_count = 0;
+	}
+	return result;
+}
+
+// call before running each frame, returns true if the frame was rewound
+static bool core_rewind_frame(void)
+{
+	if (core_rewind_size != rewind_size_mb || (rewind_buffer && snapshot_size != rewind_state_size))
+	{
+		if (core_rewind_size > 0) core_rewind_alloc();
+		else core_rewind_free();
+	}
+	if (!rewind_buffer) return false;
+
+	// a halted machine can be rewound, but not recorded
+	if (core_runflags & CORE_RUNFLAG_PAUSE) return false;
+	if (core_input_rewind) return core_rewind_step();
+	if (core_runflags & CORE_RUNFLAG_HALT) return false;
+
+	// skip hidden frames (e.g. run-ahead), which will be replaced by a savestate restore
+	int av = 3;
+	if (environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av) && !(av & 1)) return false;
+
+	core_rewind_push();
+	return false;
+}
+
 //
 // config update
 //
@@ -1045,14 +1385,16 @@ RETRO_API void retro_init(void)
 	retro_log(RETRO_LOG_INFO,"retro_init()\n");
 
 	// try to get the best pixel format we can
-	// (after Hatari 2.5.0 we can only produce XRGB8888)
+	// (after Hatari 2.5.0 we can only produce XRGB8888, hatariB adds RGB565)
 	{
 		const char* PIXEL_FORMAT_NAMES[3] = { "0RGB1555", "XRGB8888", "RGB565" };
+		int want_565 = 0;
+		cfg_read_int("hatarib_pixel_format",&want_565);
 		core_pixel_format = -1;
-		if      (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_XRGB8888)) core_pixel_format = 1;
-		//else if (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_RGB565  )) core_pixel_format = 2;
+		if      (want_565 && environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_RGB565)) core_pixel_format = 2;
+		else if (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_XRGB8888)) core_pixel_format = 1;
+		else if (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_RGB565  )) core_pixel_format = 2;
 		//else if (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, (void*)&RPF_0RGB1555)) core_pixel_format = 0;
-		(void)RPF_RGB565;
 		(void)RPF_0RGB1555;
 		if (core_pixel_format < 0)
 		{
@@ -1063,6 +1405,13 @@ RETRO_API void retro_init(void)
 			retro_log(RETRO_LOG_INFO,"Pixel format: %s\n",PIXEL_FORMAT_NAMES[core_pixel_format]);
 	}
 
+	// NULL video frames can be sent when the screen has not changed
+	core_video_dupe = false;
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &core_video_dupe))
+		core_video_dupe = false;
+	core_video_dirty = true;
+	retro_log(RETRO_LOG_INFO,"Frame duping: %s\n",core_video_dupe ? "yes" : "no");
+
 	// initialize other modules
 	core_input_init();
 	core_disk_init();
@@ -1181,6 +1530,45 @@ RETRO_API void retro_reset(void)
 	}
 }
 
+#ifdef DEBUG_SAVESTATE_BENCHMARK
+#define DEBUG_SAVESTATE_BENCHMARK_FRAMES   100
+static int debug_savestate_benchmark = DEBUG_SAVESTATE_BENCHMARK + (2 * DEBUG_SAVESTATE_BENCHMARK_FRAMES);
+static void core_savestate_benchmark(void)
+{
+	static retro_time_t total[2][2] = {{0,0},{0,0}}; // [incremental][restore]
+	static int used[2] = {0,0};
+	if (debug_savestate_benchmark <= 0 || retro_perf == NULL) return;
+	--debug_savestate_benchmark;
+	if (debug_savestate_benchmark >= (2 * DEBUG_SAVESTATE_BENCHMARK_FRAMES)) return;
+
+	int delta = (debug_savestate_benchmark < DEBUG_SAVESTATE_BENCHMARK_FRAMES) ? 1 : 0;
+	snapshot_buffer_prepare(snapshot_size,NULL);
+	core_savestate_delta = delta;
+	retro_time_t t0 = retro_perf->get_time_usec();
+	core_serialize(true);
+	retro_time_t t1 = retro_perf->get_time_usec();
+	core_savestate_delta = false;
+	if (snapshot_max > used[delta]) used[delta] = snapshot_max;
+	m68k_go_frame(); // hidden frame
+	retro_time_t t2 = retro_perf->get_time_usec();
+	core_serialize(false);
+	retro_time_t t3 = retro_perf->get_time_usec();
+	core_audio_discard();
+	total[delta][0] += t1 - t0;
+	total[delta][1] += t3 - t2;
+
+	if (debug_savestate_benchmark == 0)
+	{
+		retro_log(RETRO_LOG_INFO,"Savestate benchmark, %d KB ST RAM, average of %d frames:\n",
+			(int)(STRamEnd / 1024), DEBUG_SAVESTATE_BENCHMARK_FRAMES);
+		retro_log(RETRO_LOG_INFO,"  complete:    save %6d us, restore %6d us, %8d bytes\n",
+			(int)(total[0][0] / DEBUG_SAVESTATE_BENCHMARK_FRAMES), (int)(total[0][1] / DEBUG_SAVESTATE_BENCHMARK_FRAMES), used[0]);
+		retro_log(RETRO_LOG_INFO,"  incremental: save %6d us, restore %6d us, %8d bytes (largest)\n",
+			(int)(total[1][0] / DEBUG_SAVESTATE_BENCHMARK_FRAMES), (int)(total[1][1] / DEBUG_SAVESTATE_BENCHMARK_FRAMES), used[1]);
+	}
+}
+#endif
+
 RETRO_API void retro_run(void)
 {
 	PERF_START(PERF_RUN);
@@ -1220,11 +1608,15 @@ RETRO_API void retro_run(void)
 	if (core_runflags & CORE_RUNFLAG_OSK || core_osk_screen_restore)
 	{
 		core_osk_restore(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		core_video_dirty = true;
 	}
 
 	// handle any pending configuration updates
 	core_config_update(false);
 
+	// record this frame for rewind, or step back to the previous one
+	bool rewound = core_rewind_frame();
+
 	//retro_log(RETRO_LOG_DEBUG,"retro_run()\n");
 	// poll input, generate event queue for hatari
 	core_input_update();
@@ -1271,11 +1663,41 @@ RETRO_API void retro_run(void)
 	// force hatari to process the input queue before each frame starts
 	core_input_post();
 
+	// hidden frames (run-ahead, netplay replay) still emulate everything, but skip drawing and audio output
+	{
+		int av_enable = 3;
+		if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+			av_enable = 3;
+		core_video_enable = (av_enable & 1) != 0;
+		core_audio_enable = (av_enable & 2) != 0 && !(av_enable & 8); // 8 = hard disable audio
+
+		// fast-forward turbo: emulation is unchanged, but most frames are not drawn and audio tone filters are skipped
+		bool ff = false;
+		if (core_ff_frameskip > 1 && environ_cb(RETRO_ENVIRONMENT_GET_FASTFORWARDING, &ff) && ff)
+		{
+			if (++core_ff_frame >= core_ff_frameskip) core_ff_frame = 0;
+			if (core_ff_frame != 0) core_video_enable = false;
+		}
+		else
+		{
+			ff = false;
+			core_ff_frame = 0;
+		}
+		core_audio_filter = core_audio_enable && !ff;
+		core_screen_enable(core_video_enable);
+	}
+
 	// run one frame
 	if (!(core_runflags & (CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE)))
 	{
+		#ifdef DEBUG_SAVESTATE_BENCHMARK
+			core_savestate_benchmark();
+		#endif
 		m68k_go_frame();
 		core_flush_audio();
+		// rewinding plays back silence
+		if (rewound)
+			core_audio_silence();
 	}
 	else if (core_crashtime && ((core_runflags & (CORE_RUNFLAG_HALT | CORE_RUNFLAG_PAUSE)) == CORE_RUNFLAG_HALT))
 	{
@@ -1298,6 +1720,7 @@ RETRO_API void retro_run(void)
 		environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &info);
 		core_rate_changed = false;
 		core_video_changed = false;
+		core_video_dirty = true;
 	}
 	else if (core_video_changed)
 	{
@@ -1306,10 +1729,11 @@ RETRO_API void retro_run(void)
 		retro_get_system_av_info(&info);
 		environ_cb(RETRO_ENVIRONMENT_SET_GEOMETRY, &info);
 		core_video_changed = false;
+		core_video_dirty = true;
 	}
 
 	// statusbar may need to be redrawn
-	if (core_statusbar_restore)
+	if (core_statusbar_restore && core_video_enable)
 	{
 		core_statusbar_update();
 		core_statusbar_restore = false;
@@ -1318,18 +1742,32 @@ RETRO_API void retro_run(void)
 	// draw overlay
 	if (core_runflags & CORE_RUNFLAG_OSK)
 	{
-		core_osk_render(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		if (core_video_enable)
+			core_osk_render(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		else
+			core_osk_skip();
+		core_video_dirty = true;
 	}
 
 	// performance counters (video_cb may block, so we don't want to include it in our performance measure)
 	PERF_STOP(PERF_RUN);
 	if (core_perf_display) core_perf_show();
 
-	// send video
-	video_cb(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+	// send video, or NULL to repeat the last frame if nothing has been drawn since
+	if (core_video_dupe && !core_video_dirty)
+	{
+		video_cb(NULL,core_video_w,core_video_h,core_video_pitch);
+	}
+	else
+	{
+		video_cb(core_video_buffer,core_video_w,core_video_h,core_video_pitch);
+		// a frame the frontend won't show (e.g. run-ahead) can't be repeated later
+		if (core_video_enable)
+			core_video_dirty = false;
+	}
 
 	// fill audio if pause
-	if (core_runflags & (CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_HALT))
+	if ((core_runflags & (CORE_RUNFLAG_PAUSE | CORE_RUNFLAG_HALT)) && core_audio_enable)
 	{
 		// how many new samples should we need?
 		// use floating point to allow fractionals
@@ -1343,16 +1781,13 @@ RETRO_API void retro_run(void)
 		//retro_log(RETRO_LOG_DEBUG,"audio hold: %d\n",hold_samples);
 	}
 
-	// send audio
-	if (core_audio_samples_pending > 0)
+	// send audio, one call per contiguous span
+	for (int i=0; i<core_audio_spans; ++i)
 	{
-		unsigned int len = core_audio_samples_pending;
-		if (len > AUDIO_BUFFER_LEN) len = AUDIO_BUFFER_LEN;
-		audio_batch_cb(core_audio_buffer, len/2);
-		//retro_log(RETRO_LOG_DEBUG,"audio_batch_cb(%p,%d)\n",core_audio_buffer,len/2);
-		core_audio_samples_pending = 0;
-		//retro_log(RETRO_LOG_DEBUG,"audio send: %d\n",len/2);
+		audio_batch_cb(core_audio_span_data[i], core_audio_span_len[i]);
+		//retro_log(RETRO_LOG_DEBUG,"audio_batch_cb(%p,%d)\n",core_audio_span_data[i],core_audio_span_len[i]);
 	}
+	core_audio_discard();
 
 	// event queue end of frame
 	core_input_finish();
@@ -1483,18 +1918,298 @@ RETRO_API void retro_run(void)
 #endif
 }
 
+//
+// compressed savestates
+//
+
+static uint8_t* savestate_compress_buffer = NULL;
+static int savestate_compress_buffer_size = 0;
+static uint8_t* savestate_compress_blocks = NULL;
+static size_t savestate_compress_blocks_size = 0;
+
+static void core_savestate_compress_free(void)
+{
+	free(savestate_compress_buffer); savestate_compress_buffer = NULL;
+	savestate_compress_buffer_size = 0;
+	free(savestate_compress_blocks); savestate_compress_blocks = NULL;
+	savestate_compress_blocks_size = 0;
+}
+
+static uint8_t* core_savestate_compress_temp(void)
+{
+	if (savestate_compress_buffer && savestate_compress_buffer_size == snapshot_size)
+		return savestate_compress_buffer;
+	core_savestate_compress_free();
+	savestate_compress_buffer = malloc(snapshot_size);
+	if (savestate_compress_buffer == NULL)
+	{
+		retro_log(RETRO_LOG_ERROR,"Unable to allocate compressed savestate buffer: %d bytes\n",snapshot_size);
+		return NULL;
+	}
+	savestate_compress_buffer_size = snapshot_size;
+	return savestate_compress_buffer;
+}
+
+// scratch space for compressing blocks in parallel, kept to avoid reallocating it every save
+static uint8_t* core_savestate_compress_blocks(size_t size)
+{
+	if (savestate_compress_blocks && savestate_compress_blocks_size == size)
+		return savestate_compress_blocks;
+	free(savestate_compress_blocks);
+	savestate_compress_blocks = malloc(size);
+	savestate_compress_blocks_size = savestate_compress_blocks ? size : 0;
+	return savestate_compress_blocks;
+}
+
+static bool core_savestate_is_compressed(const void* data, size_t size)
+{
+	uint32_t magic;
+	if (size < sizeof(magic)) return false;
+	memcpy(&magic,data,sizeof(magic));
+	return magic == SNAPSHOT_COMPRESS_MAGIC;
+}
+
+// one thread's share of the blocks: first, first+stride, ...
+typedef struct
+{
+	bool pack;
+	uint32_t first;
+	uint32_t stride; // number of threads
+	uint32_t count;
+	uint32_t raw_len;
+	uint32_t block;
+	uint8_t* raw; // uncompressed savestate
+	uint8_t* z; // compressed blocks
+	size_t* zpos; // position of each block in z
+	uint32_t* zlen; // compressed length of each block
+	int failed; // first block that failed, or -1
+} savestate_compress_job;
+
+static int core_savestate_compress_thread(void* data)
+{
+	savestate_compress_job* job = (savestate_compress_job*)data;
+	for (uint32_t i=job->first; i<job->count; i+=job->stride)
+	{
+		uint32_t offset = i * job->block;
+		uint32_t len = job->raw_len - offset;
+		if (len > job->block) len = job->block;
+		if (job->pack)
+		{
+			uLongf zlen = job->zlen[i]; // room for the block
+			if (compress2(job->z+job->zpos[i],&zlen,job->raw+offset,len,SNAPSHOT_COMPRESS_LEVEL) != Z_OK)
+			{
+				job->failed = i;
+				break;
+			}
+			job->zlen[i] = (uint32_t)zlen;
+		}
+		else
+		{
+			uLongf outlen = len;
+			if (uncompress(job->raw+offset,&outlen,job->z+job->zpos[i],job->zlen[i]) != Z_OK || outlen != len)
+			{
+				job->failed = i;
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+// runs the blocks described by job on up to SNAPSHOT_COMPRESS_THREADS threads, returns the first failed block or -1
+static int core_savestate_compress_run(const savestate_compress_job* job)
+{
+	savestate_compress_job jobs[SNAPSHOT_COMPRESS_THREADS];
+	int failed = -1;
+	int thread_count = 1;
+#if SNAPSHOT_COMPRESS_THREADS > 1
+	// a single core host stays on the calling thread
+	static int cpu_count = 0;
+	if (cpu_count <= 0) cpu_count = SDL_GetCPUCount();
+	thread_count = (cpu_count < SNAPSHOT_COMPRESS_THREADS) ? cpu_count : SNAPSHOT_COMPRESS_THREADS;
+	if (thread_count < 1) thread_count = 1;
+#endif
+	for (int t=0; t<thread_count; ++t)
+	{
+		jobs[t] = *job;
+		jobs[t].first = t;
+		jobs[t].stride = thread_count;
+		jobs[t].failed = -1;
+	}
+#if SNAPSHOT_COMPRESS_THREADS > 1
+	SDL_Thread* threads[SNAPSHOT_COMPRESS_THREADS] = {NULL};
+	for (int t=1; t<thread_count && (uint32_t)t<job->count; ++t)
+	{
+		threads[t] = SDL_CreateThread(core_savestate_compress_thread,"hatarib_savestate",&jobs[t]);
+		if (threads[t] == NULL) core_savestate_compress_thread(&jobs[t]); // do it here if no thread is available
+	}
+#endif
+	core_savestate_compress_thread(&jobs[0]);
+	for (int t=0; t<thread_count; ++t)
+	{
+#if SNAPSHOT_COMPRESS_THREADS > 1
+		if (threads[t]) SDL_WaitThread(threads[t],NULL);
+#endif
+		if (jobs[t].failed >= 0 && (failed < 0 || jobs[t].failed < failed))
+			failed = jobs[t].failed;
+	}
+	return failed;
+}
+
+// compress src_len bytes of a raw savestate into data, false if it doesn't fit
+static bool core_savestate_pack(void* data, size_t size, const uint8_t* src, uint32_t src_len)
+{
+	uint8_t* out = (uint8_t*)data;
+	uint32_t head[4];
+	uint32_t count = (src_len + SNAPSHOT_COMPRESS_BLOCK - 1) / SNAPSHOT_COMPRESS_BLOCK;
+	size_t table = sizeof(head) + (count * sizeof(uint32_t));
+	if (table > size) return false;
+	head[0] = SNAPSHOT_COMPRESS_MAGIC;
+	head[1] = src_len;
+	head[2] = SNAPSHOT_COMPRESS_BLOCK;
+	head[3] = count;
+	memcpy(out,head,sizeof(head));
+
+	// the blocks are compressed in parallel to separate slots, then packed together
+	size_t slot = compressBound(SNAPSHOT_COMPRESS_BLOCK);
+	uint8_t* z = core_savestate_compress_blocks(slot * count);
+	size_t* zpos = malloc(sizeof(size_t) * count);
+	uint32_t* zlen = malloc(sizeof(uint32_t) * count);
+	savestate_compress_job job = { true, 0, 1, count, src_len, SNAPSHOT_COMPRESS_BLOCK, (uint8_t*)src, z, zpos, zlen, -1 };
+	bool result = false;
+	if (z == NULL || zpos == NULL || zlen == NULL)
+	{
+		retro_log(RETRO_LOG_ERROR,"Unable to allocate savestate compression buffers: %d blocks\n",count);
+		goto pack_end;
+	}
+	for (uint32_t i=0; i<count; ++i)
+	{
+		zpos[i] = i * slot;
+		zlen[i] = (uint32_t)slot;
+	}
+	if (core_savestate_compress_run(&job) >= 0) goto pack_end;
+
+	size_t pos = table;
+	for (uint32_t i=0; i<count; ++i)
+	{
+		if (zlen[i] > (size - pos)) goto pack_end;
+		memcpy(out+pos,z+zpos[i],zlen[i]);
+		memcpy(out+sizeof(head)+(i*sizeof(uint32_t)),&zlen[i],sizeof(uint32_t));
+		pos += zlen[i];
+	}
+	if (pos < size) memset(out+pos,0,size-pos);
+	//retro_log(RETRO_LOG_DEBUG,"core_savestate_pack: %d -> %d bytes\n",src_len,(int)pos);
+	result = true;
+pack_end:
+	free(zpos);
+	free(zlen);
+	return result;
+}
+
+// decompress a compressed savestate into dst (dst_size bytes), zero filling the remainder
+static bool core_savestate_unpack(const void* data, size_t size, uint8_t* dst, uint32_t dst_size)
+{
+	const uint8_t* in = (const uint8_t*)data;
+	uint32_t head[4];
+	if (size < sizeof(head)) return false;
+	memcpy(head,in,sizeof(head));
+	uint32_t raw_len = head[1];
+	uint32_t block = head[2];
+	uint32_t count = head[3];
+	if (raw_len > dst_size || block == 0 || count != ((raw_len + block - 1) / block))
+	{
+		retro_log(RETRO_LOG_ERROR,"Compressed savestate header invalid, or too large: %d > %d\n",raw_len,dst_size);
+		return false;
+	}
+	size_t pos = sizeof(head) + (count * sizeof(uint32_t));
+	if (pos > size) return false;
+
+	// find all the blocks first, so that they can be decompressed in parallel
+	size_t* zpos = malloc(sizeof(size_t) * count);
+	uint32_t* zlen = malloc(sizeof(uint32_t) * count);
+	savestate_compress_job job = { false, 0, 1, count, raw_len, block, dst, (uint8_t*)in, zpos, zlen, -1 };
+	bool result = false;
+	int failed;
+	if (zpos == NULL || zlen == NULL)
+	{
+		retro_log(RETRO_LOG_ERROR,"Unable to allocate savestate decompression buffers: %d blocks\n",count);
+		goto unpack_end;
+	}
+	for (uint32_t i=0; i<count; ++i)
+	{
+		memcpy(&zlen[i],in+sizeof(head)+(i*sizeof(uint32_t)),sizeof(uint32_t));
+		if (zlen[i] > (size - pos))
+		{
+			retro_log(RETRO_LOG_ERROR,"Compressed savestate block %d corrupt.\n",i);
+			goto unpack_end;
+		}
+		zpos[i] = pos;
+		pos += zlen[i];
+	}
+	failed = core_savestate_compress_run(&job);
+	if (failed >= 0)
+	{
+		retro_log(RETRO_LOG_ERROR,"Compressed savestate block %d corrupt.\n",failed);
+		goto unpack_end;
+	}
+	if (raw_len < dst_size) memset(dst+raw_len,0,dst_size-raw_len);
+	result = true;
+unpack_end:
+	free(zpos);
+	free(zlen);
+	return result;
+}
+
 RETRO_API size_t retro_serialize_size(void)
 {
 	return snapshot_size;
 }
 
+// savestates that will only be restored by this same instance
+static bool core_savestate_same_instance_context(void)
+{
+	int context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &context)) return false;
+	return context == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE;
+}
+
+// incremental savestates can only be restored by this same instance
+static bool core_savestate_delta_context(void)
+{
+	if (!core_savestate_delta_enable) return false;
+	return core_savestate_same_instance_context();
+}
+
+// ordinary savestates that may be kept, as opposed to run-ahead or netplay
+static bool core_savestate_normal_context(void)
+{
+	int context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+	environ_cb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &context); // frontends without this are assumed normal
+	return context == RETRO_SAVESTATE_CONTEXT_NORMAL;
+}
+
 RETRO_API bool retro_serialize(void *data, size_t size)
 {
 	bool result = false;
 	PERF_START(PERF_SERIALIZE);
 	//retro_log(RETRO_LOG_DEBUG,"retro_serialize(%p,%d)\n",data,size);
-	snapshot_buffer_prepare(size,data);
-	if (core_serialize(true))
+	uint8_t* compress_temp = NULL;
+	core_savestate_delta = core_savestate_delta_context();
+	core_savestate_local = core_savestate_same_instance_context();
+	if (core_savestate_compress && !core_savestate_delta && size == (size_t)snapshot_size && core_savestate_normal_context())
+		compress_temp = core_savestate_compress_temp();
+	snapshot_buffer_prepare(size,compress_temp ? (void*)compress_temp : data);
+	bool serialized = core_serialize(true);
+	core_savestate_delta = false;
+	core_savestate_local = false;
+	if (serialized && compress_temp)
+	{
+		// fall back to the raw savestate if it does not compress to fit
+		if (!core_savestate_pack(data,size,compress_temp,(uint32_t)snapshot_max))
+			memcpy(data,compress_temp,size);
+		snapshot_buffer = data;
+	}
+	if (serialized)
 	{
 		// to test a broken savestate, corrupt its version string
 		//++snapshot_buffer[SNAPSHOT_HEADER_SIZE+1];
@@ -1518,10 +2233,24 @@ RETRO_API bool retro_unserialize(const void *data, size_t size)
 	PERF_START(PERF_UNSERIALIZE);
 	//retro_log(RETRO_LOG_DEBUG,"retro_unserialize(%p,%z)\n",data,size);
 	//core_debug_bin(data,size,0);
+	if (core_savestate_is_compressed(data,size))
+	{
+		uint8_t* compress_temp = core_savestate_compress_temp();
+		if (compress_temp == NULL || !core_savestate_unpack(data,size,compress_temp,(uint32_t)snapshot_size))
+		{
+			PERF_STOP(PERF_UNSERIALIZE);
+			return false;
+		}
+		data = compress_temp;
+		size = snapshot_size;
+	}
 	snapshot_buffer_prepare(size,(void*)data);
-	if (core_serialize(false))
+	core_savestate_local = core_savestate_same_instance_context();
+	bool serialized = core_serialize(false);
+	core_savestate_local = false;
+	if (serialized)
 	{
-		core_audio_samples_pending = 0; // clear all pending audio
+		core_audio_discard(); // clear all pending audio
 		//core_trace_next(20); // verify instructions after savestate are the same as after restore (make with DEBUG=1)
 		result = true;
 	}
@@ -1556,20 +2285,17 @@ RETRO_API bool retro_load_game(const struct retro_game_info *game)
 	m68k_go_frame();
 	core_init_return = false;
 
-	// create a dummy savestate to measure the needed snapshot size
+	// measure the largest savestate needed, variable parts report their maximum and nothing is copied
 	free(snapshot_buffer_internal); snapshot_buffer_internal = NULL;
 	snapshot_buffer = NULL;
+	core_snapshot_size_query = true;
 	core_serialize(true);
+	core_snapshot_size_query = false;
 	snapshot_size = snapshot_max + SNAPSHOT_OVERHEAD;
-	// if we've got more than 1MB RAM we should increase our minimum to accomodate it
-	int minimum = SNAPSHOT_MINIMUM;
-	if (STRamEnd > (1024*1024))
-		minimum += (STRamEnd - (1024*1024));
-	if (snapshot_size < minimum)
-		snapshot_size = minimum;
 	// round up
 	if (snapshot_size % SNAPSHOT_ROUND)
 		snapshot_size += (SNAPSHOT_ROUND - (snapshot_size % SNAPSHOT_ROUND));
+	retro_log(RETRO_LOG_INFO,"Savestate size: %d bytes\n",snapshot_size);
 
 	retro_memory_maps();
 
@@ -1589,6 +2315,8 @@ RETRO_API void retro_unload_game(void)
 {
 	retro_log(RETRO_LOG_DEBUG,"retro_unload_game()\n");
 	core_disk_unload_game(); // chance to save
+	core_rewind_free();
+	core_savestate_compress_free();
 }
 
 RETRO_API unsigned retro_get_region(void)
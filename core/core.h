@@ -87,6 +87,17 @@ extern void core_snapshot_close(void);
 extern void core_snapshot_read(char* buf, int len);
 extern void core_snapshot_write(const char* buf, int len);
 extern void core_snapshot_seek(int pos);
+extern void core_snapshot_skip(int len);
+extern bool core_snapshot_size_query; // savestate write that only measures the largest size needed, nothing is stored
+// savestate buffer, exposed for the inline MemorySnapShot_Store (memorySnapShot.h)
+extern uint8_t* snapshot_buffer;
+extern int snapshot_pos;
+extern int snapshot_max;
+extern int snapshot_size;
+// rewind savestate restore, RAM is only copied where it or the savestate has changed (stMemory.c)
+extern bool core_savestate_rewind;
+#define CORE_REWIND_BLOCK_SHIFT   12
+extern uint8_t* core_rewind_changed; // per 4KB block of the rewind savestate, modified since it was last saved or restored
 
 extern int core_rand(void);
 
@@ -156,6 +156,30 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 		NULL, "system",
 		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
 	},
+	{
+		"hatarib_savestate_delta", "Run-Ahead Incremental Savestates", NULL,
+		"Run-ahead savestates only store the ST RAM pages modified since a recent reference copy,"
+		" which makes them much faster to save and restore."
+		" Only applies to run-ahead in the same instance, other savestates are always complete.",
+		NULL, "system",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
+	},
+	{
+		"hatarib_savestate_compress", "Compressed Savestates", NULL,
+		"Compresses ordinary savestates, which are mostly empty memory, to a fraction of their size."
+		" Run-ahead and netplay savestates are never compressed."
+		" Both compressed and uncompressed savestates can always be restored.",
+		NULL, "system",
+		{{"0","Off"},{"1","On"},{NULL,NULL}}, "0"
+	},
+	{
+		"hatarib_rewind", "Rewind Buffer", NULL,
+		"Keeps recent history in memory so that a Retropad button mapped to Rewind can step backwards."
+		" Each frame only stores the differences from the one after it, so this is much faster and smaller than RetroArch's rewind,"
+		" which should be left off while this is in use. Larger buffers hold more history.",
+		NULL, "system",
+		{{"0","Off"},{"16","16 MB"},{"32","32 MB"},{"64","64 MB"},{"128","128 MB"},{"256","256 MB"},{NULL,NULL}}, "0"
+	},
 	{
 		"hatarib_soft_reset", "Soft Reset", NULL,
 		"Core Restart is full cold boot by default (power off, on),"
@@ -639,6 +663,33 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 		NULL, "video",
 		{{"0","Off"},{"1","On"},{NULL,NULL}}, "1"
 	},
+	{
+		"hatarib_ff_frameskip", "Fast-Forward Frame Skip", NULL,
+		"While fast-forwarding, only draw some of the frames and skip the audio tone filters."
+		" Emulation is unaffected, this only reduces the work done to display it.",
+		NULL, "video",
+		{
+			{"1","Off"},
+			{"2","Draw 1 of 2"},
+			{"4","Draw 1 of 4"},
+			{"8","Draw 1 of 8"},
+			{"16","Draw 1 of 16"},
+			{NULL,NULL}
+		}, "4"
+	},
+	{
+		"hatarib_pixel_format", "Pixel Format", NULL,
+		"RGB565 halves the size of each video frame, which may help slower devices."
+		" Falcon/TT colours lose a little precision."
+		" Requires content close and re-open.",
+		NULL, "video",
+		{{"0","XRGB8888"},{"1","RGB565"},{NULL,NULL}},
+#ifdef SF2000
+		"1"
+#else
+		"0"
+#endif
+	},
 	//
 	// Audio
 	//
@@ -670,13 +721,15 @@ static struct retro_core_option_v2_definition CORE_OPTION_DEF[] = {
 	},
 	{
 		"hatarib_lpf", "Lowpass Filter", NULL,
-		"Reduces high frequency noise from sound output to reduce harshness.",
+		"Reduces high frequency noise from sound output to reduce harshness."
+		" Polyphase FIR also removes the aliasing of very high notes.",
 		NULL, "audio",
 		{
 			{"0","None"},
 			{"1","Hatari STF"},
 			{"2","Hatari STE/Falcon"},
 			{"3","Clean Lowpass"},
+			{"4","Polyphase FIR"},
 			{NULL,NULL}
 		}, "3"
 	},
@@ -1120,6 +1173,9 @@ void core_config_read_newparam()
 	CFG_INT("hatarib_fast_floppy") newparam.DiskImage.FastFloppy = vi;
 	CFG_INT("hatarib_save_floppy") core_disk_enable_save = vi;
 	CFG_INT("hatarib_savestate_floppy_modify") core_savestate_floppy_modify = (vi != 0);
+	CFG_INT("hatarib_savestate_delta") core_savestate_delta_enable = (vi != 0);
+	CFG_INT("hatarib_savestate_compress") core_savestate_compress = (vi != 0);
+	CFG_INT("hatarib_rewind") core_rewind_size = vi;
 	CFG_INT("hatarib_soft_reset") core_option_soft_reset = vi;
  	CFG_INT("hatarib_machine")
 	{
@@ -1194,6 +1250,7 @@ void core_config_read_newparam()
 	CFG_INT("hatarib_pause_osk") core_pause_osk = vi;
 	CFG_INT("hatarib_show_welcome") core_show_welcome = vi;
 	CFG_INT("hatarib_boot_alert") core_boot_alert = vi;
+	CFG_INT("hatarib_ff_frameskip") core_ff_frameskip = vi;
 	CFG_INT("hatarib_samplerate") newparam.Sound.nPlaybackFreq = vi;
 	CFG_INT("hatarib_ymmix") newparam.Sound.YmVolumeMixing = vi;
 	CFG_INT("hatarib_lpf") newparam.Sound.YmLpf = vi;
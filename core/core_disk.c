@@ -1091,6 +1091,18 @@ void core_disk_reindex(void)
 	}
 }
 
+// floppy.c uses this to find an image by its hash during savestate restore
+bool core_disk_get_image(unsigned int index, const char** filename, void** data, unsigned int* size, void** extra_data, unsigned int* extra_size)
+{
+	if (index >= MAX_DISKS) return false;
+	*filename = disks[index].filename;
+	*data = disks[index].data;
+	*size = disks[index].size;
+	*extra_data = disks[index].extra_data;
+	*extra_size = disks[index].extra_size;
+	return true;
+}
+
 void core_disk_drive_toggle(void)
 {
 	drive = drive ^ 1;
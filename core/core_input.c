@@ -83,6 +83,7 @@ uint8_t osk_press_mod;
 int32_t osk_press_key;
 int32_t osk_press_time;
 int32_t jm_toggle_index = -1;
+bool core_input_rewind = false;
 
 // input state that is temporary
 static int32_t joy_fire[JOY_PORTS];
@@ -405,6 +406,7 @@ void core_input_update(void)
 	bool statusbar = false;
 	bool jm_toggle = false;
 	int jm_toggle_source = -1;
+	bool rewind = false;
 	bool pause = false;
 	bool osk_on = false;
 	bool osk_shot = false;
@@ -674,8 +676,7 @@ void core_input_update(void)
 				if (input_osk_key && is_osk) continue; // when using OSK hide these buttons
 
 				// regular mappings
-				if (m >= (BUTTON_KEY_START + BUTTON_KEY_COUNT)) continue;
-				if (m >= BUTTON_KEY_START)
+				if (m >= BUTTON_KEY_START && m < (BUTTON_KEY_START + BUTTON_KEY_COUNT))
 				{
 					if (!input_paused)
 						core_input_keyboard_joy(BUTTON_KEY[m-BUTTON_KEY_START]);
@@ -801,6 +802,9 @@ void core_input_update(void)
 						jm_toggle = true;
 						jm_toggle_source = i; // always affects the last person to press it
 						break;
+					case 120: // Rewind
+						rewind = true;
+						break;
 					}
 				}
 			}
@@ -951,6 +955,7 @@ void core_input_update(void)
 		cpu_speed = false;
 		statusbar = false;
 		jm_toggle = false;
+		rewind = false;
 		if (input_osk_shot) pause = false; // cancel only if in OSK one-shot mode (otherwise we need it to unpause!)
 	}
 	else
@@ -995,6 +1000,9 @@ void core_input_update(void)
 	}
 	AUX_SET(jm_toggle,JM_TOGGLE);
 
+	// rewind is held rather than toggled, and applied at the start of the next frame
+	core_input_rewind = rewind;
+
 	// pause/help toggle
 	// onscreen keyboard toggle
 	if (pause && !AUX(PAUSE))
@@ -19,8 +19,12 @@ extern bool core_serialize_write; // current serialization direction
 extern int core_crashtime;
 extern bool core_show_welcome;
 extern bool core_boot_alert;
+extern int core_ff_frameskip;
 extern bool core_first_reset;
 extern bool core_perf_display;
+extern bool core_savestate_delta_enable;
+extern bool core_savestate_compress;
+extern int core_rewind_size; // MB, 0 = disabled
 extern bool core_midi_enable;
 extern int core_video_fps;
 extern bool core_statusbar_restore;
@@ -133,6 +137,10 @@ extern void core_disk_save_close_extra(corefile* file, bool success); // finishe
 extern bool core_disk_save_write(const uint8_t* data, unsigned int size, corefile* file);
 extern bool core_disk_save_exists(const char* filename);
 
+// used by savestate restore to find the source of a floppy image that is not in its drive,
+// returns false past the end of the list, data is NULL for an unused entry.
+extern bool core_disk_get_image(unsigned int index, const char** filename, void** data, unsigned int* size, void** extra_data, unsigned int* extra_size);
+
 extern bool core_disk_enable_b;
 extern bool core_disk_enable_save;
 extern bool core_savestate_floppy_modify;
@@ -142,6 +150,7 @@ extern void core_config_set_environment(retro_environment_t cb); // call after c
 extern void core_config_apply(void);
 extern void core_config_reset(void);
 extern bool core_config_hard_content(const char* path, int ht);
+extern bool cfg_read_int(const char* key, int* v); // read a core option directly, false if unavailable
 extern void config_cycle_cpu_speed(void);
 extern void config_toggle_statusbar(void);
 
@@ -153,6 +162,7 @@ extern void core_input_post(void); // call to force hatari to process the input
 extern void core_input_finish(void); // call at end of retro_run
 extern void core_input_serialize(void);
 extern void core_input_osk_close(void); // call to set core_osk_mode = CORE_OSK_OFF
+extern bool core_input_rewind; // rewind button is held
 #if CORE_DEBUG
 extern bool core_input_debug;
 #endif
@@ -221,6 +231,7 @@ extern int core_oskey_map[4][CORE_INPUT_OSKEY_TOTAL];
 extern void core_osk_input(uint32_t osk_new, uint32_t osk_now); // bitfield of new OSK button presses (sent by core_input_poll)
 extern void core_osk_render(void* video_buffer, int w, int h, int pitch); // call to render overlay over video_buffer
 extern void core_osk_restore(void* video_buffer, int w, int h, int pitch); // call to restore buffer before overlay
+extern void core_osk_skip(void); // call instead of core_osk_render for a frame that won't be shown
 extern void core_osk_serialize(void);
 extern void core_osk_serialize_screen(void);
 extern void core_osk_init(void);
@@ -386,6 +397,7 @@ extern int32_t core_osk_mode;
 		{"","Key Numpad 7"}, \
 		{"","Key Numpad 8"}, \
 		{"","Key Numpad 9"}, \
+		{"120","Rewind"}, \
 		{NULL,NULL} \
 	}
 // default should match OPTION_PAD below
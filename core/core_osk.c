@@ -29,6 +29,7 @@ int32_t core_osk_pos_c;
 int32_t core_osk_pos_space; // last column before moving to spacebar so up can return to it and not always Z
 uint8_t core_osk_pos_display;
 bool core_osk_screen_restore = false;
+bool core_osk_begin_skipped = false; // begin frame was not drawn, reinitialize on the next render
 
 void* screen = NULL;
 void* screen_copy = NULL;
@@ -645,6 +646,12 @@ void core_osk_render(void* video_buffer, int w, int h, int pitch)
 		return;
 	}
 
+	if (core_osk_begin_skipped)
+	{
+		core_osk_begin = 1;
+		core_osk_begin_skipped = false;
+	}
+
 	screen = video_buffer;
 	screen_size = (uint32_t)(h * pitch);
 	if (screen == NULL)
@@ -687,6 +694,14 @@ void core_osk_render(void* video_buffer, int w, int h, int pitch)
 	core_osk_begin = 0;
 }
 
+void core_osk_skip(void)
+{
+	// a frame the frontend won't show is not drawn,
+	// but core_osk_begin is part of the savestate so it must advance as if it had been
+	if (core_osk_begin) core_osk_begin_skipped = true;
+	core_osk_begin = 0;
+}
+
 void core_osk_restore(void* video_buffer, int w, int h, int pitch)
 {
 	core_osk_screen_restore = false;
@@ -726,15 +741,17 @@ void core_osk_serialize(void)
 void core_osk_serialize_screen(void)
 {
 	// only append screen if in pause/one-shot, otherwise it is not needed
+	// the savestate size doesn't reserve room for it, so it is left out if it doesn't fit
 	uint32_t serial_screen_size = 0;
-	if (core_osk_mode == CORE_OSK_PAUSE || core_osk_mode == CORE_OSK_KEY_SHOT)
+	if (core_osk_mode == CORE_OSK_PAUSE || core_osk_mode == CORE_OSK_KEY_SHOT || core_snapshot_size_query)
 	{
 		core_serialize_uint32(&screen_w);
 		core_serialize_uint32(&screen_h);
 		core_serialize_uint32(&screen_p);
 		if (core_serialize_write)
 		{
-			if (screen && screen_copy_size >= screen_size)
+			if (screen && screen_copy_size >= screen_size && snapshot_buffer &&
+				(snapshot_pos + sizeof(serial_screen_size) + screen_size) <= snapshot_size)
 			{
 				serial_screen_size = screen_size;
 				core_serialize_uint32(&serial_screen_size);
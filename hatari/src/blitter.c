@@ -854,6 +854,308 @@ static void Blitter_Step(void)
 }
 
 
+#ifdef __LIBRETRO__
+/*-----------------------------------------------------------------------*/
+/**
+ * Blitter emulation - direct ST RAM path
+ *
+ * For blits without halftone (HOP 0 or 2), Blitter_Direct_Table holds one
+ * function per HOP/LOP that does the same work as repeated Blitter_Step()
+ * calls, but reads and writes STRam[] directly and keeps the registers in
+ * locals. It stops at a word boundary before any word that would :
+ *  - access memory outside of ST RAM above 0x10000 (or use the MMU banks)
+ *  - reach the maximum number of bus accesses in non-hog mode
+ * and Blitter_Start() then lets Blitter_Step() process that word.
+ * Cycles are only added and flushed after the bus access where the next CycInt
+ * interrupt is due (as Blitter_Step() would do) and at the end.
+ * With the DSP, the accesses before the due one are flushed first, so the DSP
+ * has run for them before CycInt_Process() handles the interrupt.
+ */
+
+typedef void (*BLITTER_DIRECT_FUNC)(void);
+
+static BLITTER_DIRECT_FUNC	Blitter_ComputeDirect;
+static uint32_t		Blitter_DirectMax;			/* last valid value of 'addr - 0x10000' for a word */
+
+#define	BLITTER_DIRECT(addr)	( (uint32_t)( (addr) - 0x10000 ) <= Blitter_DirectMax )
+
+/* Count 1 bus access, flush cycles if this is where a CycInt interrupt is due */
+#define	BLITTER_DIRECT_BUS_ACCESS(bus_cycles) \
+	cycles += bus_cycles; \
+	if ( ( ( clock + cycles ) << CYCINT_SHIFT ) >= limit ) \
+	{ \
+		if ( bDspEnabled && cycles > bus_cycles ) \
+		{ \
+			Blitter_AddCycles ( cycles - bus_cycles ); \
+			Blitter_FlushCycles(); \
+			cycles = bus_cycles; \
+		} \
+		Blitter_AddCycles ( cycles ); \
+		Blitter_FlushCycles(); \
+		cycles = 0; \
+		clock = Blitter_Direct_Clock(); \
+		limit = CycInt_ActiveInt_Cycles; \
+	}
+
+/*
+ * Clock value before the next bus access, including the cycles that
+ * Blitter_AddCycles() and Blitter_FlushCycles() add with it
+ */
+static inline uint64_t Blitter_Direct_Clock ( void )
+{
+	uint64_t clock = CyclesGlobalClockCounter + WaitStateCycles;
+
+	if ( BLITTER_RUN_CE )
+		clock += currcycle * 2 / CYCLE_UNIT;
+	return clock;
+}
+
+static inline uint16_t Blitter_Direct_LOP ( int lop , uint16_t hop , uint16_t dst )
+{
+	switch ( lop )
+	{
+		case 0x0: return 0;
+		case 0x1: return hop & dst;
+		case 0x2: return hop & ~dst;
+		case 0x3: return hop;
+		case 0x4: return ~hop & dst;
+		case 0x5: return dst;
+		case 0x6: return hop ^ dst;
+		case 0x7: return hop | dst;
+		case 0x8: return ~hop & ~dst;
+		case 0x9: return ~hop ^ dst;
+		case 0xA: return ~dst;
+		case 0xB: return hop | ~dst;
+		case 0xC: return ~hop;
+		case 0xD: return ~hop | dst;
+		case 0xE: return ~hop | ~dst;
+		default:  return 0xFFFF;
+	}
+}
+
+static inline __attribute__((always_inline)) void Blitter_Direct ( int hop , int lop )
+{
+	const bool	need_src = Blitter_LOP_Table[lop].need_src && ( hop & 2 );
+	uint64_t	limit = CycInt_ActiveInt_Cycles;
+	uint64_t	clock = Blitter_Direct_Clock();
+	uint32_t	src_addr = BlitterRegs.src_addr;
+	uint32_t	dst_addr = BlitterRegs.dst_addr;
+	uint32_t	x_count = BlitterRegs.x_count;
+	uint32_t	y_count = BlitterRegs.y_count;
+	uint32_t	buffer = BlitterVars.buffer;
+	uint16_t	bus_word = BlitterState.bus_word;
+	uint16_t	dst_word = BlitterState.dst_word;
+	uint16_t	end_mask = BlitterState.end_mask;
+	uint8_t		fxsr = BlitterState.fxsr;
+	uint8_t		nfsr = BlitterState.nfsr;
+	uint8_t		have_fxsr = BlitterState.have_fxsr;
+	uint8_t		need_dst = BlitterState.need_dst;
+	uint8_t		halftone_line = BlitterVars.halftone_line;
+	uint32_t	count_bus = BlitterState.CountBusBlitter;
+	uint32_t	cycles = 0;
+	bool		done = false;
+
+	while ( y_count > 0 )
+	{
+		bool		FirstWord = ( x_count == BlitterVars.x_count_reset );
+		bool		do_fxsr, do_src;
+		uint16_t	lop_word, dst_data;
+		uint32_t	n;
+
+		if ( FirstWord || ( BlitterVars.x_count_reset == 1 ) )
+			end_mask = BlitterRegs.end_mask_1;
+		else if ( x_count == 1 )
+			end_mask = BlitterRegs.end_mask_3;
+		else
+			end_mask = BlitterRegs.end_mask_2;
+
+		if ( FirstWord )
+		{
+			nfsr = 0;
+			fxsr = BlitterVars.fxsr;
+		}
+
+		need_dst = Blitter_LOP_Table[lop].need_dst || ( end_mask != 0xFFFF );
+		do_fxsr = need_src && fxsr && !have_fxsr;
+		do_src = need_src && !nfsr;
+
+		/* Check this word can be processed here, else leave it to Blitter_Step() */
+		n = do_fxsr + do_src + need_dst + 1;
+		if ( !BlitterVars.hog && count_bus + n > BLITTER_NONHOG_BUS_BLITTER )
+			break;
+		if ( !BLITTER_DIRECT ( dst_addr ) )
+			break;
+		if ( do_fxsr && !BLITTER_DIRECT ( src_addr ) )
+			break;
+		if ( do_src && !BLITTER_DIRECT ( src_addr + ( do_fxsr ? BlitterRegs.src_x_incr : 0 ) ) )
+			break;
+
+		if ( do_fxsr )
+		{
+			bus_word = do_get_mem_word ( STRam + src_addr );
+			if ( BlitterRegs.src_x_incr < 0 )
+				buffer = ( buffer >> 16 ) | ( (uint32_t)bus_word << 16 );
+			else
+				buffer = ( buffer << 16 ) | bus_word;
+			src_addr += BlitterRegs.src_x_incr;
+			have_fxsr = true;
+			BLITTER_DIRECT_BUS_ACCESS ( BLITTER_CYCLES_PER_BUS_READ )
+		}
+
+		if ( do_src )
+		{
+			bus_word = do_get_mem_word ( STRam + src_addr );
+			if ( BlitterRegs.src_x_incr < 0 )
+				buffer = ( buffer >> 16 ) | ( (uint32_t)bus_word << 16 );
+			else
+				buffer = ( buffer << 16 ) | bus_word;
+			BLITTER_DIRECT_BUS_ACCESS ( BLITTER_CYCLES_PER_BUS_READ )
+		}
+
+		if ( need_dst )
+		{
+			bus_word = dst_word = do_get_mem_word ( STRam + dst_addr );
+			BLITTER_DIRECT_BUS_ACCESS ( BLITTER_CYCLES_PER_BUS_READ )
+		}
+
+		/* Special 'weird' case for x_count=1 and NFSR=1 */
+		if ( BlitterVars.nfsr && ( x_count == 1 ) )
+		{
+			if ( BlitterRegs.src_x_incr < 0 )
+				buffer = ( buffer >> 16 ) | ( (uint32_t)bus_word << 16 );
+			else
+				buffer = ( buffer << 16 ) | bus_word;
+		}
+
+		lop_word = Blitter_Direct_LOP ( lop , hop ? (uint16_t)( buffer >> BlitterVars.skew ) : 0xFFFF , dst_word );
+		if ( end_mask != 0xFFFF )
+			dst_data = ( lop_word & end_mask ) | ( dst_word & ~end_mask );
+		else
+			dst_data = lop_word;
+
+		STMemory_MarkDirty2 ( dst_addr , 2 );
+		do_put_mem_word ( STRam + dst_addr , dst_data );
+		bus_word = dst_data;
+		BLITTER_DIRECT_BUS_ACCESS ( BLITTER_CYCLES_PER_BUS_WRITE )
+
+		if ( BlitterVars.nfsr && ( x_count == 1 ) )
+		{
+			if ( BlitterRegs.src_x_incr < 0 )
+				buffer = ( buffer >> 16 ) | ( (uint32_t)bus_word << 16 );
+			else
+				buffer = ( buffer << 16 ) | bus_word;
+		}
+
+		count_bus += n;
+		done = true;
+
+		/* Same updates as at the end of Blitter_Step() */
+		if ( ( x_count == 2 ) && BlitterVars.nfsr )
+			nfsr = 1;
+
+		if ( do_src )
+		{
+			if ( ( x_count == 1 ) || ( nfsr == 1 ) )
+				src_addr += BlitterRegs.src_y_incr;
+			else
+				src_addr += BlitterRegs.src_x_incr;
+		}
+
+		if ( x_count == 1 )
+		{
+			have_fxsr = false;
+			y_count--;
+			x_count = BlitterVars.x_count_reset;
+
+			dst_addr += BlitterRegs.dst_y_incr;
+
+			if ( BlitterRegs.dst_y_incr >= 0 )
+				halftone_line = ( halftone_line+1 ) & 15;
+			else
+				halftone_line = ( halftone_line-1 ) & 15;
+		}
+		else
+		{
+			x_count--;
+			dst_addr += BlitterRegs.dst_x_incr;
+		}
+	}
+
+	if ( !done )
+		return;
+
+	BlitterRegs.src_addr = src_addr;
+	BlitterRegs.dst_addr = dst_addr;
+	BlitterRegs.x_count = x_count;
+	BlitterRegs.y_count = y_count;
+	BlitterVars.buffer = buffer;
+	BlitterVars.halftone_line = halftone_line;
+	BlitterState.bus_word = bus_word;
+	BlitterState.dst_word = dst_word;
+	BlitterState.end_mask = end_mask;
+	BlitterState.fxsr = fxsr;
+	BlitterState.nfsr = nfsr;
+	BlitterState.have_fxsr = have_fxsr;
+	BlitterState.need_src = need_src;
+	BlitterState.need_dst = need_dst;
+	BlitterState.CountBusBlitter = count_bus;
+	Blitter_FlushWordState ( false );
+
+	if ( cycles > 0 )
+	{
+		Blitter_AddCycles ( cycles );
+		Blitter_FlushCycles();
+	}
+}
+
+#define	BLITTER_DIRECT_FUNCS(hop) \
+	static void Blitter_Direct_##hop##_0(void) { Blitter_Direct ( hop , 0x0 ); } \
+	static void Blitter_Direct_##hop##_1(void) { Blitter_Direct ( hop , 0x1 ); } \
+	static void Blitter_Direct_##hop##_2(void) { Blitter_Direct ( hop , 0x2 ); } \
+	static void Blitter_Direct_##hop##_3(void) { Blitter_Direct ( hop , 0x3 ); } \
+	static void Blitter_Direct_##hop##_4(void) { Blitter_Direct ( hop , 0x4 ); } \
+	static void Blitter_Direct_##hop##_5(void) { Blitter_Direct ( hop , 0x5 ); } \
+	static void Blitter_Direct_##hop##_6(void) { Blitter_Direct ( hop , 0x6 ); } \
+	static void Blitter_Direct_##hop##_7(void) { Blitter_Direct ( hop , 0x7 ); } \
+	static void Blitter_Direct_##hop##_8(void) { Blitter_Direct ( hop , 0x8 ); } \
+	static void Blitter_Direct_##hop##_9(void) { Blitter_Direct ( hop , 0x9 ); } \
+	static void Blitter_Direct_##hop##_A(void) { Blitter_Direct ( hop , 0xA ); } \
+	static void Blitter_Direct_##hop##_B(void) { Blitter_Direct ( hop , 0xB ); } \
+	static void Blitter_Direct_##hop##_C(void) { Blitter_Direct ( hop , 0xC ); } \
+	static void Blitter_Direct_##hop##_D(void) { Blitter_Direct ( hop , 0xD ); } \
+	static void Blitter_Direct_##hop##_E(void) { Blitter_Direct ( hop , 0xE ); } \
+	static void Blitter_Direct_##hop##_F(void) { Blitter_Direct ( hop , 0xF ); }
+
+#define	BLITTER_DIRECT_ROW(hop) \
+	{ Blitter_Direct_##hop##_0, Blitter_Direct_##hop##_1, Blitter_Direct_##hop##_2, Blitter_Direct_##hop##_3, \
+	  Blitter_Direct_##hop##_4, Blitter_Direct_##hop##_5, Blitter_Direct_##hop##_6, Blitter_Direct_##hop##_7, \
+	  Blitter_Direct_##hop##_8, Blitter_Direct_##hop##_9, Blitter_Direct_##hop##_A, Blitter_Direct_##hop##_B, \
+	  Blitter_Direct_##hop##_C, Blitter_Direct_##hop##_D, Blitter_Direct_##hop##_E, Blitter_Direct_##hop##_F }
+
+BLITTER_DIRECT_FUNCS(0)
+BLITTER_DIRECT_FUNCS(2)
+
+static const BLITTER_DIRECT_FUNC Blitter_Direct_Table [2][16] =
+{
+	BLITTER_DIRECT_ROW(0),			/* HOP 0 : all ones */
+	BLITTER_DIRECT_ROW(2)			/* HOP 2 : source */
+};
+
+static void Blitter_Select_Direct(void)
+{
+	Blitter_ComputeDirect = NULL;
+
+	/* Halftone HOPs and ST RAM with MMU address translation use Blitter_Step() only */
+	if ( ( BlitterRegs.hop & 1 ) || STRamEnd <= 0x10000
+	  || !( get_mem_bank ( 0x10000 ).flags & ABFLAG_DIRECTACCESS ) )
+		return;
+
+	Blitter_DirectMax = STRamEnd - 0x10000 - 2;
+	Blitter_ComputeDirect = Blitter_Direct_Table[ BlitterRegs.hop >> 1 ][ BlitterRegs.lop ];
+}
+#endif
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Start/Resume the blitter
@@ -876,6 +1178,9 @@ Video_GetPosition ( &FrameCycles , &HblCounterVideo , &LineCycles );
 	/* Select HOP & LOP funcs */
 	Blitter_Select_HOP();
 	Blitter_Select_LOP();
+#ifdef __LIBRETRO__
+	Blitter_Select_Direct();
+#endif
 
 	/* Setup vars */
 	BlitterVars.pass_cycles = 0;
@@ -892,12 +1197,29 @@ Video_GetPosition ( &FrameCycles , &HblCounterVideo , &LineCycles );
 	MFP_GPIP_Set_Line_Input ( pMFP_Main , MFP_GPIP_LINE_GPU_DONE , MFP_GPIP_STATE_HIGH );
 
 	/* Now we enter the main blitting loop */
+#ifdef __LIBRETRO__
+	do
+	{
+		/* Process as many words as possible directly, then 1 word with Blitter_Step() */
+		if ( Blitter_ComputeDirect && !BlitterState.ContinueLater )
+		{
+			Blitter_ComputeDirect();
+			if ( BlitterRegs.y_count == 0
+			  || ( !BlitterVars.hog && !Blitter_ContinueNonHog() ) )
+				break;
+		}
+		Blitter_Step();
+	}
+	while ( BlitterRegs.y_count > 0
+	       && ( BlitterVars.hog || Blitter_ContinueNonHog() ) );
+#else
 	do
 	{
 		Blitter_Step();
 	}
 	while ( BlitterRegs.y_count > 0
 	       && ( BlitterVars.hog || Blitter_ContinueNonHog() ) );
+#endif
 
 	/* Bus arbitration */
 	Blitter_BusArbitration ( BUS_MODE_CPU );
@@ -29,6 +29,14 @@ static void ConvertLowRes_320x32Bit(void)
 
 		x = STScreenWidthBytes>>3; /* Amount to draw across in 16-pixels (8 bytes) */
 
+#ifdef __LIBRETRO__
+		if (bConvertSimd)
+		{
+			if (Convert_SimdLine_Low_320_32Bit(edi, ebp, esi, x, update))
+				bScreenContentsChanged = true;
+		}
+		else
+#endif
 		do    /* x-loop */
 		{
 			/* Do 16 pixels at one time */
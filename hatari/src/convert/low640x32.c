@@ -16,6 +16,15 @@ static void Line_ConvertLowRes_640x32Bit(Uint32 *edi, Uint32 *ebp, Uint32 *esi,
 	x = STScreenWidthBytes>>3;   /* Amount to draw across in 16-pixels (8 bytes) */
 	update = ScrUpdateFlag & PALETTEMASK_UPDATEMASK;
 
+#ifdef __LIBRETRO__
+	if (bConvertSimd)
+	{
+		if (Convert_SimdLine_Low_640_32Bit(edi, ebp, esi, x, update))
+			bScreenContentsChanged = true;
+		return;
+	}
+#endif
+
 	do    /* x-loop */
 	{
 		/* Do 16 pixels at one time */
@@ -43,6 +43,15 @@ static void Line_ConvertMediumRes_640x32Bit(Uint32 *edi, Uint32 *ebp, Uint32 *es
 	x = STScreenWidthBytes >> 2;   /* Amount to draw across in 16-pixels (4 bytes) */
 	update = ScrUpdateFlag & PALETTEMASK_UPDATEMASK;
 
+#ifdef __LIBRETRO__
+	if (bConvertSimd)
+	{
+		if (Convert_SimdLine_Med_640_32Bit(edi, ebp, esi, x, update))
+			bScreenContentsChanged = true;
+		return;
+	}
+#endif
+
 	do  /* x-loop */
 	{
 		/* Do 16 pixels at one time */
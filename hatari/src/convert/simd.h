@@ -0,0 +1,357 @@
+/*
+  Hatari - simd.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  SIMD planar to chunky conversion for the low and medium resolution
+  32-bit and 16-bit converters (hatariB).
+
+  A block of 16 pixels is transposed from its bit planes into 16 palette
+  indices in one vector, and the indices are looked up all at once by
+  byte shuffles against STRGBPalette split into 4 byte planes.
+  In 16-bit mode each palette entry holds the pixel twice,
+  so only the lowest 2 byte planes are needed.
+  x86 uses SSSE3 when the CPU has it, ARM uses NEON when built for it,
+  otherwise bConvertSimd stays false and the macros in macros.h are used.
+
+  Each function converts a whole line of 16-pixel blocks, skipping blocks
+  that are unchanged from the previous frame unless 'update' is set,
+  and returns true if anything was drawn.
+*/
+
+#ifndef HATARI_CONVERTSIMD_H
+#define HATARI_CONVERTSIMD_H
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+# if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define CONVERT_SIMD_SSSE3 1
+#  include <tmmintrin.h>
+#  define CONVERT_SIMD_TARGET __attribute__((target("ssse3")))
+# elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define CONVERT_SIMD_NEON 1
+#  include <arm_neon.h>
+#  define CONVERT_SIMD_TARGET
+# endif
+#endif
+
+static bool bConvertSimd = false;      /* true if the SIMD kernels can be used */
+
+static void Convert_SimdInit(void)
+{
+#if defined(CONVERT_SIMD_SSSE3)
+	__builtin_cpu_init();
+	bConvertSimd = __builtin_cpu_supports("ssse3");
+#elif defined(CONVERT_SIMD_NEON)
+	bConvertSimd = true;
+#endif
+}
+
+#if defined(CONVERT_SIMD_SSSE3)
+
+typedef struct { __m128i b, g, r, a; } ConvertSimdPalette;
+
+/* Split STRGBPalette into its 4 byte planes */
+static inline ConvertSimdPalette CONVERT_SIMD_TARGET Convert_SimdPalette(void)
+{
+	const __m128i split = _mm_setr_epi8(0,4,8,12,1,5,9,13,2,6,10,14,3,7,11,15);
+	const __m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(STRGBPalette+0)), split);
+	const __m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(STRGBPalette+4)), split);
+	const __m128i v2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(STRGBPalette+8)), split);
+	const __m128i v3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(STRGBPalette+12)), split);
+	const __m128i bg0 = _mm_unpacklo_epi32(v0, v1);
+	const __m128i bg1 = _mm_unpacklo_epi32(v2, v3);
+	const __m128i ra0 = _mm_unpackhi_epi32(v0, v1);
+	const __m128i ra1 = _mm_unpackhi_epi32(v2, v3);
+	ConvertSimdPalette pal;
+
+	pal.b = _mm_unpacklo_epi64(bg0, bg1);
+	pal.g = _mm_unpackhi_epi64(bg0, bg1);
+	pal.r = _mm_unpacklo_epi64(ra0, ra1);
+	pal.a = _mm_unpackhi_epi64(ra0, ra1);
+	return pal;
+}
+
+/* 16 pixel indices from 4 planes (low res) or 2 planes (medium res) */
+static inline __m128i CONVERT_SIMD_TARGET Convert_SimdIndex(const Uint32 *edi, int planes)
+{
+	const __m128i bits = _mm_setr_epi8(-128,64,32,16,8,4,2,1,-128,64,32,16,8,4,2,1);
+	/* medium res only has 4 bytes left in the block, don't read past the end of the line */
+	const __m128i src = (planes > 2) ? _mm_loadl_epi64((const __m128i *)edi) : _mm_cvtsi32_si128((int)edi[0]);
+	__m128i idx = _mm_setzero_si128();
+	int p;
+
+	for (p = 0; p < planes; p++)
+	{
+		/* high byte of the big endian plane word is the left 8 pixels */
+		const __m128i spread = _mm_setr_epi8(2*p,2*p,2*p,2*p,2*p,2*p,2*p,2*p,
+		                                     2*p+1,2*p+1,2*p+1,2*p+1,2*p+1,2*p+1,2*p+1,2*p+1);
+		__m128i plane = _mm_shuffle_epi8(src, spread);
+		plane = _mm_cmpeq_epi8(_mm_and_si128(plane, bits), bits);
+		idx = _mm_or_si128(idx, _mm_and_si128(plane, _mm_set1_epi8(1 << p)));
+	}
+	return idx;
+}
+
+/* Look up 16 pixel indices and store them as 16 32-bit pixels */
+static inline void CONVERT_SIMD_TARGET Convert_SimdPlot(const ConvertSimdPalette *pal, __m128i idx, Uint32 *esi)
+{
+	const __m128i b = _mm_shuffle_epi8(pal->b, idx);
+	const __m128i g = _mm_shuffle_epi8(pal->g, idx);
+	const __m128i r = _mm_shuffle_epi8(pal->r, idx);
+	const __m128i a = _mm_shuffle_epi8(pal->a, idx);
+	const __m128i bg0 = _mm_unpacklo_epi8(b, g);
+	const __m128i bg1 = _mm_unpackhi_epi8(b, g);
+	const __m128i ra0 = _mm_unpacklo_epi8(r, a);
+	const __m128i ra1 = _mm_unpackhi_epi8(r, a);
+
+	_mm_storeu_si128((__m128i *)(esi+0),  _mm_unpacklo_epi16(bg0, ra0));
+	_mm_storeu_si128((__m128i *)(esi+4),  _mm_unpackhi_epi16(bg0, ra0));
+	_mm_storeu_si128((__m128i *)(esi+8),  _mm_unpacklo_epi16(bg1, ra1));
+	_mm_storeu_si128((__m128i *)(esi+12), _mm_unpackhi_epi16(bg1, ra1));
+}
+
+/* Same, but doubled horizontally to 32 pixels */
+static inline void CONVERT_SIMD_TARGET Convert_SimdPlotDouble(const ConvertSimdPalette *pal, __m128i idx, Uint32 *esi)
+{
+	Convert_SimdPlot(pal, _mm_unpacklo_epi8(idx, idx), esi);
+	Convert_SimdPlot(pal, _mm_unpackhi_epi8(idx, idx), esi+16);
+}
+
+/* Look up 16 pixel indices and store them as 16 16-bit pixels */
+static inline void CONVERT_SIMD_TARGET Convert_SimdPlot16(const ConvertSimdPalette *pal, __m128i idx, Uint16 *esi)
+{
+	const __m128i lo = _mm_shuffle_epi8(pal->b, idx);
+	const __m128i hi = _mm_shuffle_epi8(pal->g, idx);
+
+	_mm_storeu_si128((__m128i *)(esi+0), _mm_unpacklo_epi8(lo, hi));
+	_mm_storeu_si128((__m128i *)(esi+8), _mm_unpackhi_epi8(lo, hi));
+}
+
+/* Same, but doubled horizontally to 32 pixels */
+static inline void CONVERT_SIMD_TARGET Convert_SimdPlot16Double(const ConvertSimdPalette *pal, __m128i idx, Uint16 *esi)
+{
+	Convert_SimdPlot16(pal, _mm_unpacklo_epi8(idx, idx), esi);
+	Convert_SimdPlot16(pal, _mm_unpackhi_epi8(idx, idx), esi+16);
+}
+
+#elif defined(CONVERT_SIMD_NEON)
+
+typedef uint8x16x4_t ConvertSimdPalette;
+
+/* Split STRGBPalette into its 4 byte planes */
+static inline ConvertSimdPalette Convert_SimdPalette(void)
+{
+	return vld4q_u8((const Uint8 *)STRGBPalette);
+}
+
+/* 16 pixel indices from 4 planes (low res) or 2 planes (medium res) */
+static inline uint8x16_t Convert_SimdIndex(const Uint32 *edi, int planes)
+{
+	static const Uint8 bitlist[16] = { 128,64,32,16,8,4,2,1,128,64,32,16,8,4,2,1 };
+	const uint8x16_t bits = vld1q_u8(bitlist);
+	const Uint8 *src = (const Uint8 *)edi;
+	uint8x16_t idx = vdupq_n_u8(0);
+	int p;
+
+	for (p = 0; p < planes; p++)
+	{
+		/* high byte of the big endian plane word is the left 8 pixels */
+		uint8x16_t plane = vcombine_u8(vdup_n_u8(src[2*p]), vdup_n_u8(src[2*p+1]));
+		plane = vtstq_u8(plane, bits);
+		idx = vorrq_u8(idx, vandq_u8(plane, vdupq_n_u8(1 << p)));
+	}
+	return idx;
+}
+
+static inline uint8x16_t Convert_SimdLookup(uint8x16_t table, uint8x16_t idx)
+{
+#if defined(__aarch64__)
+	return vqtbl1q_u8(table, idx);
+#else
+	uint8x8x2_t t;
+	t.val[0] = vget_low_u8(table);
+	t.val[1] = vget_high_u8(table);
+	return vcombine_u8(vtbl2_u8(t, vget_low_u8(idx)), vtbl2_u8(t, vget_high_u8(idx)));
+#endif
+}
+
+/* Look up 16 pixel indices and store them as 16 32-bit pixels */
+static inline void Convert_SimdPlot(const ConvertSimdPalette *pal, uint8x16_t idx, Uint32 *esi)
+{
+	uint8x16x4_t px;
+	px.val[0] = Convert_SimdLookup(pal->val[0], idx);
+	px.val[1] = Convert_SimdLookup(pal->val[1], idx);
+	px.val[2] = Convert_SimdLookup(pal->val[2], idx);
+	px.val[3] = Convert_SimdLookup(pal->val[3], idx);
+	vst4q_u8((Uint8 *)esi, px); /* interleaves the byte planes back into pixels */
+}
+
+/* Same, but doubled horizontally to 32 pixels */
+static inline void Convert_SimdPlotDouble(const ConvertSimdPalette *pal, uint8x16_t idx, Uint32 *esi)
+{
+	const uint8x16x2_t dbl = vzipq_u8(idx, idx);
+	Convert_SimdPlot(pal, dbl.val[0], esi);
+	Convert_SimdPlot(pal, dbl.val[1], esi+16);
+}
+
+/* Look up 16 pixel indices and store them as 16 16-bit pixels */
+static inline void Convert_SimdPlot16(const ConvertSimdPalette *pal, uint8x16_t idx, Uint16 *esi)
+{
+	uint8x16x2_t px;
+	px.val[0] = Convert_SimdLookup(pal->val[0], idx);
+	px.val[1] = Convert_SimdLookup(pal->val[1], idx);
+	vst2q_u8((Uint8 *)esi, px);
+}
+
+/* Same, but doubled horizontally to 32 pixels */
+static inline void Convert_SimdPlot16Double(const ConvertSimdPalette *pal, uint8x16_t idx, Uint16 *esi)
+{
+	const uint8x16x2_t dbl = vzipq_u8(idx, idx);
+	Convert_SimdPlot16(pal, dbl.val[0], esi);
+	Convert_SimdPlot16(pal, dbl.val[1], esi+16);
+}
+
+#endif
+
+#if defined(CONVERT_SIMD_SSSE3) || defined(CONVERT_SIMD_NEON)
+
+/* Low res line, 16 pixels (8 bytes) to 16 32-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Low_320_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0] || edi[1] != ebp[1])
+		{
+			Convert_SimdPlot(&pal, Convert_SimdIndex(edi, 4), esi);
+			changed = true;
+		}
+		esi += 16;
+		edi += 2;
+		ebp += 2;
+	}
+	while (--x);
+	return changed;
+}
+
+/* Low res line, 16 pixels (8 bytes) to 32 32-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Low_640_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0] || edi[1] != ebp[1])
+		{
+			Convert_SimdPlotDouble(&pal, Convert_SimdIndex(edi, 4), esi);
+			changed = true;
+		}
+		esi += 32;
+		edi += 2;
+		ebp += 2;
+	}
+	while (--x);
+	return changed;
+}
+
+/* Medium res line, 16 pixels (4 bytes) to 16 32-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Med_640_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0])
+		{
+			Convert_SimdPlot(&pal, Convert_SimdIndex(edi, 2), esi);
+			changed = true;
+		}
+		esi += 16;
+		edi += 1;
+		ebp += 1;
+	}
+	while (--x);
+	return changed;
+}
+
+/* Low res line, 16 pixels (8 bytes) to 16 16-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Low_320_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0] || edi[1] != ebp[1])
+		{
+			Convert_SimdPlot16(&pal, Convert_SimdIndex(edi, 4), esi);
+			changed = true;
+		}
+		esi += 16;
+		edi += 2;
+		ebp += 2;
+	}
+	while (--x);
+	return changed;
+}
+
+/* Low res line, 16 pixels (8 bytes) to 32 16-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Low_640_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0] || edi[1] != ebp[1])
+		{
+			Convert_SimdPlot16Double(&pal, Convert_SimdIndex(edi, 4), esi);
+			changed = true;
+		}
+		esi += 32;
+		edi += 2;
+		ebp += 2;
+	}
+	while (--x);
+	return changed;
+}
+
+/* Medium res line, 16 pixels (4 bytes) to 16 16-bit pixels per block */
+static bool CONVERT_SIMD_TARGET Convert_SimdLine_Med_640_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update)
+{
+	const ConvertSimdPalette pal = Convert_SimdPalette();
+	bool changed = false;
+
+	do
+	{
+		if (update || edi[0] != ebp[0])
+		{
+			Convert_SimdPlot16(&pal, Convert_SimdIndex(edi, 2), esi);
+			changed = true;
+		}
+		esi += 16;
+		edi += 1;
+		ebp += 1;
+	}
+	while (--x);
+	return changed;
+}
+
+#else
+
+/* no SIMD available, bConvertSimd is never set */
+static bool Convert_SimdLine_Low_320_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update) { return false; }
+static bool Convert_SimdLine_Low_640_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update) { return false; }
+static bool Convert_SimdLine_Med_640_32Bit(const Uint32 *edi, const Uint32 *ebp, Uint32 *esi, int x, int update) { return false; }
+static bool Convert_SimdLine_Low_320_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update) { return false; }
+static bool Convert_SimdLine_Low_640_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update) { return false; }
+static bool Convert_SimdLine_Med_640_16Bit(const Uint32 *edi, const Uint32 *ebp, Uint16 *esi, int x, int update) { return false; }
+
+#endif
+
+#endif /* HATARI_CONVERTSIMD_H */
@@ -580,6 +580,9 @@ static void REGPARAM3 STmem_lput(uaecptr addr, uae_u32 l)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 4);
+#endif
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -587,6 +590,9 @@ static void REGPARAM3 STmem_wput(uaecptr addr, uae_u32 w)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 2);
+#endif
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -594,6 +600,9 @@ static void REGPARAM3 STmem_bput(uaecptr addr, uae_u32 b)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty(addr);
+#endif
 	STmemory[addr] = b;
 }
 
@@ -642,6 +651,9 @@ static void REGPARAM3 STmem_lput_MMU(uaecptr addr, uae_u32 l)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 4);
+#endif
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -650,6 +662,9 @@ static void REGPARAM3 STmem_wput_MMU(uaecptr addr, uae_u32 w)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 2);
+#endif
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -658,6 +673,9 @@ static void REGPARAM3 STmem_bput_MMU(uaecptr addr, uae_u32 b)
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty(addr);
+#endif
 	STmemory[addr] = b;
 }
 
@@ -733,6 +751,9 @@ static void REGPARAM3 SysMem_lput(uaecptr addr, uae_u32 l)
 		return;
 	}
 
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 4);
+#endif
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -758,6 +779,9 @@ static void REGPARAM3 SysMem_wput(uaecptr addr, uae_u32 w)
 		}
 	}
 
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 2);
+#endif
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -774,6 +798,9 @@ static void REGPARAM3 SysMem_bput(uaecptr addr, uae_u32 b)
 		return;
 	}
 
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty(addr);
+#endif
 	STmemory[addr] = b;
 }
 
@@ -845,6 +872,9 @@ static void REGPARAM3 SysMem_lput_MMU(uaecptr addr, uae_u32 l)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 4);
+#endif
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -871,6 +901,9 @@ static void REGPARAM3 SysMem_wput_MMU(uaecptr addr, uae_u32 w)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty2(addr, 2);
+#endif
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -888,6 +921,9 @@ static void REGPARAM3 SysMem_bput_MMU(uaecptr addr, uae_u32 b)
 	}
 
 	addr = STMemory_MMU_Translate_Addr ( addr );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirty(addr);
+#endif
 	STmemory[addr] = b;
 }
 
@@ -2089,6 +2125,10 @@ void memory_put_long(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab->baseaddr_direct_w == STRam)
+			STMemory_MarkDirty2(addr, 4);
+#endif
 		do_put_mem_long((uae_u32*)m, v);
 	}
 }
@@ -2102,6 +2142,10 @@ void memory_put_word(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab->baseaddr_direct_w == STRam)
+			STMemory_MarkDirty2(addr, 2);
+#endif
 		do_put_mem_word((uae_u16*)m, v);
 	}
 }
@@ -2115,6 +2159,10 @@ void memory_put_byte(uaecptr addr, uae_u32 v)
 		addr -= ab->startaccessmask;
 		addr &= ab->mask;
 		m = ab->baseaddr_direct_w + addr;
+#ifdef __LIBRETRO__
+		if (ab->baseaddr_direct_w == STRam)
+			STMemory_MarkDirty(addr);
+#endif
 		*m = (uae_u8)v;
 	}
 }
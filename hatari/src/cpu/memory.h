@@ -555,6 +555,45 @@ uae_u32 memory_get_byte(uaecptr);
 uae_u32 memory_get_longi(uaecptr);
 uae_u32 memory_get_wordi(uaecptr);
 
+#ifdef __LIBRETRO__
+/* Inline version of memory_get_xxx() : banks with a direct pointer (RAM, ROM) */
+/* are read in place, IO / bus error / MMU banks still use their functions. */
+STATIC_INLINE uae_u32 get_long(uaecptr addr)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_r)
+		return call_mem_get_func(ab->lget, addr);
+	return do_get_mem_long((uae_u32*)(ab->baseaddr_direct_r + ((addr - ab->startaccessmask) & ab->mask)));
+}
+STATIC_INLINE uae_u32 get_word (uaecptr addr)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_r)
+		return call_mem_get_func(ab->wget, addr);
+	return do_get_mem_word((uae_u16*)(ab->baseaddr_direct_r + ((addr - ab->startaccessmask) & ab->mask)));
+}
+STATIC_INLINE uae_u32 get_byte (uaecptr addr)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_r)
+		return call_mem_get_func(ab->bget, addr);
+	return ab->baseaddr_direct_r[(addr - ab->startaccessmask) & ab->mask];
+}
+STATIC_INLINE uae_u32 get_longi(uaecptr addr)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_r)
+		return call_mem_get_func(ab->lgeti, addr);
+	return do_get_mem_long((uae_u32*)(ab->baseaddr_direct_r + ((addr - ab->startaccessmask) & ab->mask)));
+}
+STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_r)
+		return call_mem_get_func(ab->wgeti, addr);
+	return do_get_mem_word((uae_u16*)(ab->baseaddr_direct_r + ((addr - ab->startaccessmask) & ab->mask)));
+}
+#else
 STATIC_INLINE uae_u32 get_long(uaecptr addr)
 {
 	return memory_get_long(addr);
@@ -575,6 +614,7 @@ STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 {
 	return memory_get_wordi(addr);
 }
+#endif
 
 // do split memory access if it can cross memory banks
 STATIC_INLINE uae_u32 get_long_compatible(uaecptr addr)
@@ -702,6 +742,47 @@ void memory_put_long(uaecptr, uae_u32);
 void memory_put_word(uaecptr, uae_u32);
 void memory_put_byte(uaecptr, uae_u32);
 
+#ifdef __LIBRETRO__
+#include "stMemory.h"		/* STRam[] dirty page tracking */
+
+/* Inline version of memory_put_xxx(), see get_long() above */
+STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_w) {
+		call_mem_put_func(ab->lput, addr, l);
+		return;
+	}
+	addr = (addr - ab->startaccessmask) & ab->mask;
+	if (ab->baseaddr_direct_w == STRam)
+		STMemory_MarkDirty2(addr, 4);
+	do_put_mem_long((uae_u32*)(ab->baseaddr_direct_w + addr), l);
+}
+STATIC_INLINE void put_word (uaecptr addr, uae_u32 w)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_w) {
+		call_mem_put_func(ab->wput, addr, w);
+		return;
+	}
+	addr = (addr - ab->startaccessmask) & ab->mask;
+	if (ab->baseaddr_direct_w == STRam)
+		STMemory_MarkDirty2(addr, 2);
+	do_put_mem_word((uae_u16*)(ab->baseaddr_direct_w + addr), w);
+}
+STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
+{
+	addrbank *ab = &get_mem_bank(addr);
+	if (!ab->baseaddr_direct_w) {
+		call_mem_put_func(ab->bput, addr, b);
+		return;
+	}
+	addr = (addr - ab->startaccessmask) & ab->mask;
+	if (ab->baseaddr_direct_w == STRam)
+		STMemory_MarkDirty(addr);
+	ab->baseaddr_direct_w[addr] = (uae_u8)b;
+}
+#else
 STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
 {
 	memory_put_long(addr, l);
@@ -714,6 +795,7 @@ STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
 {
 	memory_put_byte(addr, b);
 }
+#endif
 
 // do split memory access if it can cross memory banks
 STATIC_INLINE void put_long_compatible(uaecptr addr, uae_u32 l)
@@ -2026,6 +2026,22 @@ static void build_cpufunctbl (void)
 		abort ();
 	}
 
+#ifdef __LIBRETRO__
+	// don't refill the opcode tables unless something they depend on has changed
+	// (every savestate restore comes through here, and this is most of its time)
+	static const struct cputbl *table_tbl = NULL;
+	static int table_cpu_model = -1, table_fpu_model = -1, table_no_unimpl = -1, table_jit = -1;
+	opcnt = 0;
+	if (tbl == table_tbl && currprefs.cpu_model == table_cpu_model && currprefs.fpu_model == table_fpu_model &&
+		currprefs.int_no_unimplemented == table_no_unimpl && jit == table_jit)
+		goto table_done;
+	table_tbl = tbl;
+	table_cpu_model = currprefs.cpu_model;
+	table_fpu_model = currprefs.fpu_model;
+	table_no_unimpl = currprefs.int_no_unimplemented;
+	table_jit = jit;
+#endif
+
 	for (opcode = 0; opcode < 65536; opcode++) {
 		cpufunctbl[opcode] = op_illg_1;
 		cpufunctbl_noret[opcode] = op_illg_1_noret;
@@ -2127,6 +2143,9 @@ static void build_cpufunctbl (void)
 	}
 #endif
 
+#ifdef __LIBRETRO__
+table_done:
+#endif
 	write_log (_T("Building CPU, %d opcodes (%d %d %d)\n"),
 		opcnt, lvl,
 		currprefs.cpu_cycle_exact ? -2 : currprefs.cpu_memory_cycle_exact ? -1 : currprefs.cpu_compatible ? 1 : 0, currprefs.address_space_24);
@@ -72,6 +72,75 @@ const char CycInt_fileid[] = "Hatari cycInt.c";
 
 
 //#define	CYCINT_DEBUG
+//#define	CYCINT_BENCHMARK		/* log the scheduler's work and time for each emulated second */
+
+#ifdef CYCINT_BENCHMARK
+extern void core_debug_printf(const char* fmt, ...);
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define	CYCINT_BENCH_UNIT	"cycles"
+static inline uint64_t CycInt_BenchTicks(void) { return __rdtsc(); }
+#else
+#include <time.h>
+#define	CYCINT_BENCH_UNIT	"ns"
+static inline uint64_t CycInt_BenchTicks(void)
+{
+	struct timespec t;
+	clock_gettime ( CLOCK_MONOTONIC , &t );
+	return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+#endif
+
+/* Counts for the current emulated second */
+static struct
+{
+	uint64_t	Clock;			/* CPU clock at the start of this second */
+	uint64_t	Inserts, Removes, Acks;
+	uint64_t	Steps;			/* list entries passed by CycInt_InsertInt */
+	uint64_t	Length;			/* sum of the list length at each insert */
+	uint64_t	Ticks;			/* time spent in the scheduler */
+	uint64_t	Overhead;		/* time of an empty CycInt_BenchTicks pair */
+} CycInt_Bench;
+
+static void CycInt_BenchReport ( void )
+{
+	uint64_t	Clock = Cycles_GetClockCounterImmediate();
+	uint64_t	Ops , Ticks , t0;
+	int		i;
+
+	if ( CycInt_Bench.Clock == 0 || Clock < CycInt_Bench.Clock )
+	{
+		CycInt_Bench.Overhead = UINT64_MAX;
+		for ( i = 0 ; i < 100 ; i++ )
+		{
+			t0 = CycInt_BenchTicks();
+			t0 = CycInt_BenchTicks() - t0;
+			if ( t0 < CycInt_Bench.Overhead )
+				CycInt_Bench.Overhead = t0;
+		}
+		CycInt_Bench.Clock = Clock;
+		return;
+	}
+	if ( Clock - CycInt_Bench.Clock < MachineClocks.CPU_Freq_Emul )
+		return;
+
+	Ops = CycInt_Bench.Inserts + CycInt_Bench.Removes + CycInt_Bench.Acks;
+	Ticks = CycInt_Bench.Ticks - Ops * CycInt_Bench.Overhead;
+	if ( Ticks > CycInt_Bench.Ticks )
+		Ticks = 0;
+	core_debug_printf ( "cycint: %"PRIu64" inserts (%.2f steps, %.2f active), %"PRIu64" removes, %"PRIu64" acks,"
+		" %"PRIu64" "CYCINT_BENCH_UNIT" per emulated second, %.1f per op\n" ,
+		CycInt_Bench.Inserts ,
+		CycInt_Bench.Inserts ? (double)CycInt_Bench.Steps / CycInt_Bench.Inserts : 0.0 ,
+		CycInt_Bench.Inserts ? (double)CycInt_Bench.Length / CycInt_Bench.Inserts : 0.0 ,
+		CycInt_Bench.Removes , CycInt_Bench.Acks ,
+		Ticks , Ops ? (double)Ticks / Ops : 0.0 );
+
+	CycInt_Bench.Clock = Clock;
+	CycInt_Bench.Inserts = CycInt_Bench.Removes = CycInt_Bench.Acks = 0;
+	CycInt_Bench.Steps = CycInt_Bench.Length = CycInt_Bench.Ticks = 0;
+}
+#endif
 
 
 void (*PendingInterruptFunction)(void);		// TODO rename to CycInt_ActiveInt_Function
@@ -274,6 +343,14 @@ static void CycInt_InsertInt ( interrupt_id IntId )
 	} while ( n >= 0 );
 #endif
 
+#ifdef CYCINT_BENCHMARK
+	/* counted outside of the timed section, which only covers the insert itself */
+	CycInt_Bench.Inserts++;
+	for ( n = CycInt_ActiveInt ; n >= 0 ; n = InterruptHandlers[ n ].IntList_Next )
+		CycInt_Bench.Length++;
+	uint64_t bench_t0 = CycInt_BenchTicks();
+#endif
+
 	/* Search for the position to insert IntId in the linked list ; we insert just before interrupt 'n'  */
 	n = CycInt_ActiveInt;
 	prev = InterruptHandlers[ n ].IntList_Prev;
@@ -300,6 +377,12 @@ static void CycInt_InsertInt ( interrupt_id IntId )
 		InterruptHandlers[ IntId ].IntList_Prev = prev;
 		InterruptHandlers[ prev ].IntList_Next = IntId;
 	}
+#ifdef CYCINT_BENCHMARK
+	CycInt_Bench.Ticks += CycInt_BenchTicks() - bench_t0;
+	/* entries passed by the search are those now ahead of IntId */
+	for ( n = CycInt_ActiveInt ; n != (int)IntId ; n = InterruptHandlers[ n ].IntList_Next )
+		CycInt_Bench.Steps++;
+#endif
 
 #ifdef CYCINT_DEBUG
 	fprintf ( stderr , "int after active=%02d active_cyc=%"PRIu64" new=%02d cyc=%"PRIu64" clock=%"PRIu64"\n" , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , IntId , InterruptHandlers[ IntId ].Cycles , Cycles_GetClockCounterImmediate() );
@@ -320,6 +403,9 @@ static void CycInt_InsertInt ( interrupt_id IntId )
  */
 void CycInt_AcknowledgeInterrupt(void)
 {
+#ifdef CYCINT_BENCHMARK
+	uint64_t bench_t0 = CycInt_BenchTicks();
+#endif
 	/* Disable interrupt's entry which has just occurred */
 	InterruptHandlers[ CycInt_ActiveInt ].Active = false;
 
@@ -328,6 +414,11 @@ void CycInt_AcknowledgeInterrupt(void)
 	CycInt_ActiveInt_Cycles = InterruptHandlers[ CycInt_ActiveInt ].Cycles;
 	/* New ActiveInt is first of the list */
 	InterruptHandlers[ CycInt_ActiveInt ].IntList_Prev = -1;
+#ifdef CYCINT_BENCHMARK
+	CycInt_Bench.Ticks += CycInt_BenchTicks() - bench_t0;
+	CycInt_Bench.Acks++;
+	CycInt_BenchReport();
+#endif
 
 	LOG_TRACE(TRACE_INT, "int ack video_cyc=%d active_int=%d clock=%"PRIu64" active_cyc=%"PRIu64" pending_count=%d\n",
 			Cycles_GetCounter(CYCLES_COUNTER_VIDEO), CycInt_ActiveInt,
@@ -440,6 +531,9 @@ void CycInt_RemovePendingInterrupt(interrupt_id Handler)
 		return;
 	}
 
+#ifdef CYCINT_BENCHMARK
+	uint64_t bench_t0 = CycInt_BenchTicks();
+#endif
 	/* Disable interrupt's entry */
 	InterruptHandlers[Handler].Active = false;
 
@@ -458,6 +552,10 @@ void CycInt_RemovePendingInterrupt(interrupt_id Handler)
 		InterruptHandlers[ InterruptHandlers[Handler].IntList_Prev ].IntList_Next = InterruptHandlers[ Handler ].IntList_Next;
 		InterruptHandlers[ InterruptHandlers[Handler].IntList_Next ].IntList_Prev = InterruptHandlers[ Handler ].IntList_Prev;
 	}
+#ifdef CYCINT_BENCHMARK
+	CycInt_Bench.Ticks += CycInt_BenchTicks() - bench_t0;
+	CycInt_Bench.Removes++;
+#endif
 
 	LOG_TRACE(TRACE_INT, "int remove pending video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" pending_count=%d\n",
 	          Cycles_GetCounter(CYCLES_COUNTER_VIDEO), Handler,
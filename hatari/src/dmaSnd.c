@@ -113,6 +113,20 @@ const char DmaSnd_fileid[] = "Hatari dmaSnd.c";
 #include "m68000.h"
 #include "clocks_timings.h"
 
+#ifdef __LIBRETRO__
+#ifndef DMASND_LMC_FIXED
+#if defined(SF2000) || defined(__SOFTFP__) || defined(__mips_soft_float)
+#define DMASND_LMC_FIXED	/* no FPU: use the Q28 fixed point LMC1992 filter */
+#endif
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+//#define DMASND_LMC_DEBUG	/* check DmaSnd_Apply_LMC against the original per-sample filters */
+#endif
+
 #define TONE_STEPS 13
 
 #define DMASND_FIFO_SIZE	8			/* 8 bytes : size of the DMA Audio's FIFO, filled on every HBL */
@@ -123,13 +137,22 @@ const char DmaSnd_fileid[] = "Hatari dmaSnd.c";
 
 static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate);
 static void DmaSnd_Set_Tone_Level(int set_bass, int set_treb);
+#if !defined(__LIBRETRO__) || defined(DMASND_LMC_DEBUG)
 static float DmaSnd_IIRfilterL(float xn);
 static float DmaSnd_IIRfilterR(float xn);
+#endif
 static struct first_order_s *DmaSnd_Treble_Shelf(float g, float fc, float Fs);
 static struct first_order_s *DmaSnd_Bass_Shelf(float g, float fc, float Fs);
 static int16_t DmaSnd_LowPassFilterLeft(int16_t in);
 static int16_t DmaSnd_LowPassFilterRight(int16_t in);
 static bool DmaSnd_LowPass;
+#ifdef __LIBRETRO__
+extern bool core_audio_enable;
+extern bool core_audio_filter;
+#ifdef DMASND_LMC_FIXED
+static void DmaSnd_LMC_Fixed_Update(void);
+#endif
+#endif
 
 
 uint16_t nDmaSoundControl;              /* Sound control register */
@@ -287,6 +310,10 @@ void DmaSnd_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&dma, sizeof(dma));
 	MemorySnapShot_Store(&microwire, sizeof(microwire));
 	MemorySnapShot_Store(&lmc1992, sizeof(lmc1992));
+#ifdef DMASND_LMC_FIXED
+	if (!bSave)
+		DmaSnd_LMC_Fixed_Update();
+#endif
 }
 
 
@@ -681,6 +708,356 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 }
 
 
+#ifdef __LIBRETRO__
+/*-----------------------------------------------------------------------*/
+/**
+ * LMC1992 filter state for DmaSnd_Apply_LMC, [0] is left and [1] is right.
+ * Like the static data of the original per-channel filters, it is not saved.
+ */
+static struct {
+#ifdef DMASND_LMC_FIXED
+	int32_t	w1[2], w2[2];			/* biquad wn-1 and wn-2, Q4 */
+#else
+	float	w1[2], w2[2];			/* biquad wn-1 and wn-2 */
+#endif
+	yms32	hpf_x1[2], hpf_y1[2], hpf_y0[2];	/* as in Subsonic_IIR_HPF_Left/Right */
+} lmc1992_state;
+
+#ifdef DMASND_LMC_FIXED
+/* lmc1992 gains and coefficients in Q28, updated with DmaSnd_LMC_Fixed_Update */
+static struct {
+	int32_t	gain[2];
+	int32_t	coef[5];
+} lmc1992_fixed;
+
+static int32_t DmaSnd_LMC_Q28(float f)
+{
+	double d = f * 268435456.0;
+
+	return d < 0 ? -(int32_t)(0.5 - d) : (int32_t)(d + 0.5);
+}
+
+/**
+ * Convert the lmc1992 gains and coefficients to Q28 after they change.
+ */
+static void DmaSnd_LMC_Fixed_Update(void)
+{
+	int i;
+
+	lmc1992_fixed.gain[0] = DmaSnd_LMC_Q28(lmc1992.left_gain);
+	lmc1992_fixed.gain[1] = DmaSnd_LMC_Q28(lmc1992.right_gain);
+	for (i = 0; i < 5; i++)
+		lmc1992_fixed.coef[i] = DmaSnd_LMC_Q28(lmc1992.coef[i]);
+}
+#endif
+
+
+/**
+ * Apply the subsonic high pass and the LMC1992 filter to 'n' contiguous
+ * stereo samples, with the state held in locals for the whole span.
+ * Each step is done in the same order as Subsonic_IIR_HPF_Left/Right and
+ * DmaSnd_IIRfilterL/R so the float versions give identical output,
+ * the left and right channels running together in one SIMD register.
+ * The fixed point version is within 1 LSB of them.
+ */
+static void DmaSnd_LMC_Span(int16_t (*buf)[2], int n)
+{
+	const bool hpf = YM2149_HPF_Filter != YM2149_HPF_FILTER_NONE;
+	int i;
+
+#if defined(DMASND_LMC_FIXED)
+	const int32_t c0 = lmc1992_fixed.coef[0], c1 = lmc1992_fixed.coef[1];
+	const int32_t c2 = lmc1992_fixed.coef[2], c3 = lmc1992_fixed.coef[3], c4 = lmc1992_fixed.coef[4];
+	int32_t w1[2], w2[2];
+	yms32 x1[2], y1[2], y0[2];
+	int c;
+
+	memcpy(w1, lmc1992_state.w1, sizeof(w1));
+	memcpy(w2, lmc1992_state.w2, sizeof(w2));
+	memcpy(x1, lmc1992_state.hpf_x1, sizeof(x1));
+	memcpy(y1, lmc1992_state.hpf_y1, sizeof(y1));
+	memcpy(y0, lmc1992_state.hpf_y0, sizeof(y0));
+
+	for (i = 0; i < n; i++) {
+		for (c = 0; c < 2; c++) {
+			yms32 x = buf[i][c];
+			int32_t w;
+			int64_t acc;
+
+			if (hpf) {
+				y1[c] += ((x - x1[c])<<15) - (y0[c]<<6);
+				y0[c] = y1[c]>>15;
+				x1[c] = x;
+				x = (ymsample)y0[c];
+			}
+
+			/* w (Q4) = g*xn - a1*wn-1 - a2*wn-2, summed in Q32 */
+			acc  = (int64_t)lmc1992_fixed.gain[c] * x * 16;
+			acc -= (int64_t)c0 * w1[c];
+			acc -= (int64_t)c1 * w2[c];
+			w = (int32_t)((acc + (1 << 27)) >> 28);
+
+			/* yn = b0*wn + b1*wn-1 + b2*wn-2, truncated like the float to int conversion */
+			acc  = (int64_t)c2 * w;
+			acc += (int64_t)c3 * w1[c];
+			acc += (int64_t)c4 * w2[c];
+			acc += (acc >> 63) & 0xffffffff;
+			acc >>= 32;
+
+			w2[c] = w1[c];
+			w1[c] = w;
+			buf[i][c] = acc < -32767 ? -32767 : acc > 32767 ? 32767 : acc;
+		}
+	}
+
+	memcpy(lmc1992_state.w1, w1, sizeof(w1));
+	memcpy(lmc1992_state.w2, w2, sizeof(w2));
+	memcpy(lmc1992_state.hpf_x1, x1, sizeof(x1));
+	memcpy(lmc1992_state.hpf_y1, y1, sizeof(y1));
+	memcpy(lmc1992_state.hpf_y0, y0, sizeof(y0));
+
+#elif defined(__SSE2__)
+	const __m128 g = _mm_setr_ps(lmc1992.left_gain, lmc1992.right_gain, 0, 0);
+	const __m128 c0 = _mm_set1_ps(lmc1992.coef[0]);
+	const __m128 c1 = _mm_set1_ps(lmc1992.coef[1]);
+	const __m128 c2 = _mm_set1_ps(lmc1992.coef[2]);
+	const __m128 c3 = _mm_set1_ps(lmc1992.coef[3]);
+	const __m128 c4 = _mm_set1_ps(lmc1992.coef[4]);
+	const __m128 lo = _mm_set1_ps(-32767.0f), hi = _mm_set1_ps(32767.0f);
+	__m128 w1 = _mm_setr_ps(lmc1992_state.w1[0], lmc1992_state.w1[1], 0, 0);
+	__m128 w2 = _mm_setr_ps(lmc1992_state.w2[0], lmc1992_state.w2[1], 0, 0);
+	__m128i x1 = _mm_setr_epi32(lmc1992_state.hpf_x1[0], lmc1992_state.hpf_x1[1], 0, 0);
+	__m128i y1 = _mm_setr_epi32(lmc1992_state.hpf_y1[0], lmc1992_state.hpf_y1[1], 0, 0);
+	__m128i y0 = _mm_setr_epi32(lmc1992_state.hpf_y0[0], lmc1992_state.hpf_y0[1], 0, 0);
+	float fs[4];
+	int32_t is[4];
+	int32_t lr;
+
+	for (i = 0; i < n; i++) {
+		__m128i x;
+		__m128 a, y;
+
+		memcpy(&lr, buf[i], sizeof(lr));
+		x = _mm_cvtsi32_si128(lr);
+		x = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		if (hpf) {
+			y1 = _mm_add_epi32(y1, _mm_sub_epi32(_mm_slli_epi32(_mm_sub_epi32(x, x1), 15), _mm_slli_epi32(y0, 6)));
+			y0 = _mm_srai_epi32(y1, 15);
+			x1 = x;
+			x = _mm_srai_epi32(_mm_slli_epi32(y0, 16), 16);	/* returned as ymsample */
+		}
+
+		a = _mm_mul_ps(g, _mm_cvtepi32_ps(x));
+		a = _mm_sub_ps(a, _mm_mul_ps(c0, w1));
+		a = _mm_sub_ps(a, _mm_mul_ps(c1, w2));
+		y = _mm_mul_ps(c2, a);
+		y = _mm_add_ps(y, _mm_mul_ps(c3, w1));
+		y = _mm_add_ps(y, _mm_mul_ps(c4, w2));
+		w2 = w1;
+		w1 = a;
+
+		x = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(y, lo), hi));
+		lr = _mm_cvtsi128_si32(_mm_packs_epi32(x, x));
+		memcpy(buf[i], &lr, sizeof(lr));
+	}
+
+	_mm_storeu_ps(fs, w1);
+	lmc1992_state.w1[0] = fs[0];
+	lmc1992_state.w1[1] = fs[1];
+	_mm_storeu_ps(fs, w2);
+	lmc1992_state.w2[0] = fs[0];
+	lmc1992_state.w2[1] = fs[1];
+	_mm_storeu_si128((__m128i *)is, x1);
+	lmc1992_state.hpf_x1[0] = is[0];
+	lmc1992_state.hpf_x1[1] = is[1];
+	_mm_storeu_si128((__m128i *)is, y1);
+	lmc1992_state.hpf_y1[0] = is[0];
+	lmc1992_state.hpf_y1[1] = is[1];
+	_mm_storeu_si128((__m128i *)is, y0);
+	lmc1992_state.hpf_y0[0] = is[0];
+	lmc1992_state.hpf_y0[1] = is[1];
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	const float32x2_t g = { lmc1992.left_gain, lmc1992.right_gain };
+	const float32x2_t c0 = vdup_n_f32(lmc1992.coef[0]);
+	const float32x2_t c1 = vdup_n_f32(lmc1992.coef[1]);
+	const float32x2_t c2 = vdup_n_f32(lmc1992.coef[2]);
+	const float32x2_t c3 = vdup_n_f32(lmc1992.coef[3]);
+	const float32x2_t c4 = vdup_n_f32(lmc1992.coef[4]);
+	const float32x2_t lo = vdup_n_f32(-32767.0f), hi = vdup_n_f32(32767.0f);
+	float32x2_t w1 = vld1_f32(lmc1992_state.w1);
+	float32x2_t w2 = vld1_f32(lmc1992_state.w2);
+	int32x2_t x1 = vld1_s32(lmc1992_state.hpf_x1);
+	int32x2_t y1 = vld1_s32(lmc1992_state.hpf_y1);
+	int32x2_t y0 = vld1_s32(lmc1992_state.hpf_y0);
+
+	for (i = 0; i < n; i++) {
+		int32x2_t x = { buf[i][0], buf[i][1] };
+		float32x2_t a, y;
+
+		if (hpf) {
+			y1 = vadd_s32(y1, vsub_s32(vshl_n_s32(vsub_s32(x, x1), 15), vshl_n_s32(y0, 6)));
+			y0 = vshr_n_s32(y1, 15);
+			x1 = x;
+			x = vshr_n_s32(vshl_n_s32(y0, 16), 16);		/* returned as ymsample */
+		}
+
+		a = vmul_f32(g, vcvt_f32_s32(x));
+		a = vsub_f32(a, vmul_f32(c0, w1));
+		a = vsub_f32(a, vmul_f32(c1, w2));
+		y = vmul_f32(c2, a);
+		y = vadd_f32(y, vmul_f32(c3, w1));
+		y = vadd_f32(y, vmul_f32(c4, w2));
+		w2 = w1;
+		w1 = a;
+
+		x = vcvt_s32_f32(vmin_f32(vmax_f32(y, lo), hi));
+		buf[i][0] = vget_lane_s32(x, 0);
+		buf[i][1] = vget_lane_s32(x, 1);
+	}
+
+	vst1_f32(lmc1992_state.w1, w1);
+	vst1_f32(lmc1992_state.w2, w2);
+	vst1_s32(lmc1992_state.hpf_x1, x1);
+	vst1_s32(lmc1992_state.hpf_y1, y1);
+	vst1_s32(lmc1992_state.hpf_y0, y0);
+
+#else
+	const float g[2] = { lmc1992.left_gain, lmc1992.right_gain };
+	const float c0 = lmc1992.coef[0], c1 = lmc1992.coef[1];
+	const float c2 = lmc1992.coef[2], c3 = lmc1992.coef[3], c4 = lmc1992.coef[4];
+	float w1[2], w2[2];
+	yms32 x1[2], y1[2], y0[2];
+	int c;
+
+	memcpy(w1, lmc1992_state.w1, sizeof(w1));
+	memcpy(w2, lmc1992_state.w2, sizeof(w2));
+	memcpy(x1, lmc1992_state.hpf_x1, sizeof(x1));
+	memcpy(y1, lmc1992_state.hpf_y1, sizeof(y1));
+	memcpy(y0, lmc1992_state.hpf_y0, sizeof(y0));
+
+	/* Both channels in the same iteration, so their dependency chains overlap */
+	for (i = 0; i < n; i++) {
+		for (c = 0; c < 2; c++) {
+			yms32 x = buf[i][c];
+			float a, y;
+			int32_t sample;
+
+			if (hpf) {
+				y1[c] += ((x - x1[c])<<15) - (y0[c]<<6);
+				y0[c] = y1[c]>>15;
+				x1[c] = x;
+				x = (ymsample)y0[c];
+			}
+
+			a  = g[c] * x;
+			a -= c0 * w1[c];
+			a -= c1 * w2[c];
+			y  = c2 * a;
+			y += c3 * w1[c];
+			y += c4 * w2[c];
+			w2[c] = w1[c];
+			w1[c] = a;
+
+			sample = y;
+			buf[i][c] = sample < -32767 ? -32767 : sample > 32767 ? 32767 : sample;
+		}
+	}
+
+	memcpy(lmc1992_state.w1, w1, sizeof(w1));
+	memcpy(lmc1992_state.w2, w2, sizeof(w2));
+	memcpy(lmc1992_state.hpf_x1, x1, sizeof(x1));
+	memcpy(lmc1992_state.hpf_y1, y1, sizeof(y1));
+	memcpy(lmc1992_state.hpf_y0, y0, sizeof(y0));
+#endif
+}
+
+
+/**
+ * Fast-forward version of DmaSnd_LMC_Span, without the bass and treble filter.
+ * The subsonic high pass keeps its state and the volume is still applied,
+ * so the sound doesn't pop or change level when fast-forward ends.
+ */
+static void DmaSnd_LMC_Span_Gain(int16_t (*buf)[2], int n)
+{
+	const bool hpf = YM2149_HPF_Filter != YM2149_HPF_FILTER_NONE;
+	const float g[2] = { lmc1992.left_gain, lmc1992.right_gain };
+	int i, c;
+
+	for (i = 0; i < n; i++) {
+		for (c = 0; c < 2; c++) {
+			yms32 x = buf[i][c];
+			int32_t sample;
+
+			if (hpf) {
+				lmc1992_state.hpf_y1[c] += ((x - lmc1992_state.hpf_x1[c])<<15) - (lmc1992_state.hpf_y0[c]<<6);
+				lmc1992_state.hpf_y0[c] = lmc1992_state.hpf_y1[c]>>15;
+				lmc1992_state.hpf_x1[c] = x;
+				x = (ymsample)lmc1992_state.hpf_y0[c];
+			}
+
+			sample = g[c] * x;
+			buf[i][c] = sample < -32767 ? -32767 : sample > 32767 ? 32767 : sample;
+		}
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Apply LMC1992 sound modifications (Bass and Treble)
+ * The Bass and Treble get samples at nAudioFrequency rate.
+ * The tone control's sampling frequency must be at least 22050 Hz to sound good.
+ * The ring buffer is filtered in at most 2 contiguous spans.
+ */
+static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate)
+{
+	int nBufIdx = nMixBufIdx & AUDIOMIXBUFFER_SIZE_MASK;
+	int n;
+#ifdef DMASND_LMC_DEBUG
+	static int16_t expected[AUDIOMIXBUFFER_SIZE][2];
+	int i, c;
+	int32_t sample;
+#endif
+
+	/* Output filtering only, its state is not saved: not needed if the frontend won't play it */
+	if (!core_audio_enable)
+		return;
+
+#ifdef DMASND_LMC_DEBUG
+	for (i = 0; i < nSamplesToGenerate; i++) {
+		int16_t *s = AudioMixBuffer[(nBufIdx + i) & AUDIOMIXBUFFER_SIZE_MASK];
+		sample = DmaSnd_IIRfilterL( Subsonic_IIR_HPF_Left( s[0]));
+		expected[i][0] = sample < -32767 ? -32767 : sample > 32767 ? 32767 : sample;
+		sample = DmaSnd_IIRfilterR( Subsonic_IIR_HPF_Right(s[1]));
+		expected[i][1] = sample < -32767 ? -32767 : sample > 32767 ? 32767 : sample;
+	}
+#endif
+
+	while (nSamplesToGenerate > 0) {
+		n = AUDIOMIXBUFFER_SIZE - nBufIdx;
+		if (n > nSamplesToGenerate)
+			n = nSamplesToGenerate;
+		if (core_audio_filter)
+			DmaSnd_LMC_Span(AudioMixBuffer + nBufIdx, n);
+		else	/* fast-forward skips only the bass and treble */
+			DmaSnd_LMC_Span_Gain(AudioMixBuffer + nBufIdx, n);
+		nBufIdx = (nBufIdx + n) & AUDIOMIXBUFFER_SIZE_MASK;
+		nSamplesToGenerate -= n;
+#ifdef DMASND_LMC_DEBUG
+		for (i = 0; i < n && core_audio_filter; i++) {
+			int16_t *s = AudioMixBuffer[(nBufIdx - n + i) & AUDIOMIXBUFFER_SIZE_MASK];
+			for (c = 0; c < 2; c++)
+				if (abs(s[c] - expected[i][c]) > 1)
+					Log_Printf(LOG_ERROR, "DmaSnd_Apply_LMC: channel %d is %d, expected %d\n",
+						   c, s[c], expected[i][c]);
+		}
+		memmove(expected, expected + n, sizeof(expected[0]) * nSamplesToGenerate);
+#endif
+	}
+}
+
+#else
 /*-----------------------------------------------------------------------*/
 /**
  * Apply LMC1992 sound modifications (Bass and Treble)
@@ -712,6 +1089,7 @@ static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate)
 		AudioMixBuffer[nBufIdx][1] = sample;
  	}
 }
+#endif
 
 
 /*-----------------------------------------------------------------------*/
@@ -1170,6 +1548,9 @@ void DmaSnd_InterruptHandler_Microwire(void)
 				LOG_TRACE ( TRACE_DMASND, "Microwire unknown command=0x%x len=%d ignored mask=0x%x data=0x%x\n", cmd , cmd_len , microwire.mask , microwire.data );
 				break;
 		}
+#ifdef DMASND_LMC_FIXED
+		DmaSnd_LMC_Fixed_Update();
+#endif
 	}
 }
 
@@ -1257,6 +1638,7 @@ void DmaSnd_MicrowireMask_WriteWord(void)
 
 /*-------------------Bass / Treble filter ---------------------------*/
 
+#if !defined(__LIBRETRO__) || defined(DMASND_LMC_DEBUG)
 /**
  * Left voice Filter for Bass/Treble.
  */
@@ -1309,6 +1691,7 @@ static float DmaSnd_IIRfilterR(float xn)
 	data[0] = a;				/* wn -> wn-1            */
 	return yn;
 }
+#endif
 
 /**
  * LowPass Filter Left
@@ -1460,6 +1843,9 @@ void DmaSnd_Init_Bass_and_Treble_Tables(void)
 	/* Initialize IIR Filter Gain and use as a Volume Control */
 	lmc1992.left_gain = (microwire.leftVolume * (uint32_t)microwire.masterVolume) * (2.0/(65536.0*65536.0));
 	lmc1992.right_gain = (microwire.rightVolume * (uint32_t)microwire.masterVolume) * (2.0/(65536.0*65536.0));
+#ifdef DMASND_LMC_FIXED
+	DmaSnd_LMC_Fixed_Update();
+#endif
 }
 
 
@@ -343,6 +343,28 @@ static struct codec_s adc;
 static struct dsp_s dspXmit;
 static struct dsp_s dspReceive;
 
+#ifdef __LIBRETRO__
+/* Batched clock interrupts.
+ * While the ticks of a clock drive nothing the DSP or the CPU can see (no DSP
+ * transfer, no DMA play, ADC connected nowhere), one interrupt stands for up to
+ * CROSSBAR_BATCH_MAX ticks, and the ticks before the last one only advance the
+ * ADC counters. Crossbar_Batch_Split() must be called before anything changes
+ * which transfers a clock drives: it returns to one interrupt per tick, at the
+ * time the next tick would have happened without batching. */
+#define CROSSBAR_BATCH_MAX 128
+
+struct batch_s {
+	uint32_t ticks;			/* clock ticks ending with the pending interrupt (1 = not batched) */
+	uint32_t counter;		/* clockXX_cycles_counter before the first tick of the batch */
+	uint64_t end;			/* time of the pending interrupt, in cpu cycles */
+};
+
+static struct batch_s batch25;
+static struct batch_s batch32;
+
+static void Crossbar_Batch_Split(void);
+#endif
+
 /**
  * Reset Crossbar variables.
  */
@@ -418,6 +440,11 @@ void Crossbar_Reset(bool bCold)
 	crossbar.adc2dac_readBufferPosition = 0;
 	crossbar.adc2dac_readBufferPosition_float = 0;
 
+#ifdef __LIBRETRO__
+	batch25.ticks = 1;
+	batch32.ticks = 1;
+#endif
+
 	/* Start 25 Mhz and 32 Mhz Clocks */
 	Crossbar_Recalculate_Clocks_Cycles();
 	Crossbar_Start_InterruptHandler_25Mhz();
@@ -459,6 +486,10 @@ void Crossbar_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&adc, sizeof(adc));
 	MemorySnapShot_Store(&dspXmit, sizeof(dspXmit));
 	MemorySnapShot_Store(&dspReceive, sizeof(dspReceive));
+#ifdef __LIBRETRO__
+	MemorySnapShot_Store(&batch25, sizeof(batch25));
+	MemorySnapShot_Store(&batch32, sizeof(batch32));
+#endif
 
 #ifndef __LIBRETRO__
 	/* After restoring, update the clock/freq counters */
@@ -642,6 +673,10 @@ void Crossbar_DmaCtrlReg_WriteByte(void)
 
 	LOG_TRACE(TRACE_CROSSBAR, "Crossbar : $ff8901 (additional Sound DMA control) write: 0x%02x VBL=%d HBL=%d\n", sndCtrl, nVBLs , nHBL );
 
+#ifdef __LIBRETRO__
+	Crossbar_Batch_Split();
+#endif
+
 	crossbar.dmaSelected = (sndCtrl & 0x80) >> 7;
 
 	/* DMA Play mode */
@@ -1083,6 +1118,10 @@ void Crossbar_SrcControler_WriteWord(void)
 
 	LOG_TRACE(TRACE_CROSSBAR, "Crossbar : $ff8930 (source device) write: 0x%04x\n", nCbSrc);
 
+#ifdef __LIBRETRO__
+	Crossbar_Batch_Split();
+#endif
+
 	dspXmit.isTristated = 1 - ((nCbSrc >> 7) & 0x1);
 	dspXmit.isInHandshakeMode = 1 - ((nCbSrc >> 4) & 0x1);
 
@@ -1131,6 +1170,11 @@ void Crossbar_DstControler_WriteWord(void)
 
 	LOG_TRACE(TRACE_CROSSBAR, "Crossbar : $ff8932 (destination device) write: 0x%04x\n", destCtrl);
 
+#ifdef __LIBRETRO__
+	Crossbar_Batch_Split();
+	DSP_Sync();
+#endif
+
 	dspReceive.isTristated = 1 - ((destCtrl & 0x80) >> 7);
 	dspReceive.isInHandshakeMode = 1 - ((destCtrl & 0x10) >> 4);
 
@@ -1285,6 +1329,10 @@ void Crossbar_Recalculate_Clocks_Cycles(void)
 {
 	double cyclesClk;
 
+#ifdef __LIBRETRO__
+	Crossbar_Batch_Split();
+#endif
+
 	crossbar.clock25_cycles_counter = 0;
 	crossbar.clock32_cycles_counter = 0;
 
@@ -1361,6 +1409,144 @@ static int Crossbar_DetectSampleRate(uint16_t clock)
 	return Falcon_SampleRates_32Mhz[crossbar.int_freq_divider - 1];
 }
 
+#ifdef __LIBRETRO__
+/**
+ * Return the cycles to the next tick of a clock and update its decimal counter,
+ * as Crossbar_Start_InterruptHandler_25Mhz/32Mhz() do.
+ */
+static inline uint32_t Crossbar_Batch_NextCycles(uint32_t cycles, uint32_t decimal, uint32_t *counter)
+{
+	*counter += decimal;
+	if (*counter >= DECIMAL_PRECISION) {
+		*counter -= DECIMAL_PRECISION;
+		return cycles + 1;
+	}
+	return cycles;
+}
+
+/**
+ * Return true if the ticks of a clock drive no transfer that the DSP or the CPU can see.
+ *    freq : CROSSBAR_FREQ_25MHZ or CROSSBAR_FREQ_32MHZ
+ */
+static bool Crossbar_Batch_IsQuiet(uint32_t freq)
+{
+	bool dspQuiet, dmaQuiet;
+
+	/* The ADC transfers on every 25 Mhz tick */
+	if (freq == CROSSBAR_FREQ_25MHZ &&
+	    (adc.isConnectedToDsp || adc.isConnectedToDma || adc.isConnectedToCodec))
+		return false;
+
+	/* Same tests as Crossbar_Process_DSPXmit_Transfer() and Crossbar_Process_DMAPlay_Transfer() */
+	dspQuiet = dspXmit.isTristated ||
+		(!dmaRecord.isConnectedToDspInHandShakeMode &&
+		 !dspXmit.isConnectedToCodec && !dspXmit.isConnectedToDma && !dspXmit.isConnectedToDsp);
+	dmaQuiet = dmaPlay.isRunning == 0;
+
+	/* In Ste mode, the 25 Mhz clock drives all the transfers and the 32 Mhz clock none */
+	if (crossbar.isInSteFreqMode)
+		return freq == CROSSBAR_FREQ_32MHZ || (dspQuiet && dmaQuiet);
+
+	return (dspQuiet || crossbar.dspXmit_freq != freq) &&
+	       (dmaQuiet || crossbar.dmaPlay_freq != freq);
+}
+
+/**
+ * Advance the ADC counters by the given number of ticks, as
+ * Crossbar_Process_ADCXmit_Transfer() does when the ADC is connected nowhere.
+ */
+static void Crossbar_Batch_AdcTicks(uint32_t ticks)
+{
+	/* Every second tick moves to the next sample, starting with the first one if wordCount is 0 */
+	adc.readPosition = (adc.readPosition + (ticks + 1 - adc.wordCount) / 2) % DACBUFFER_SIZE;
+	adc.wordCount ^= ticks & 1;
+}
+
+/**
+ * Schedule the next interrupt of a quiet clock for a batch of ticks.
+ * Return false (and leave the clock unchanged) if the next tick must be a single interrupt.
+ */
+static bool Crossbar_Batch_Start(struct batch_s *batch, uint32_t freq, interrupt_id handler,
+                                 uint32_t cycles, uint32_t decimal, uint32_t *counter, uint32_t *pendingCyclesOver)
+{
+	uint32_t start = *counter;
+	uint32_t total, n;
+
+	batch->ticks = 1;
+	if (!Crossbar_Batch_IsQuiet(freq))
+		return false;
+
+	/* A delay longer than a tick is caught up one tick at a time */
+	total = Crossbar_Batch_NextCycles(cycles, decimal, counter);
+	if (*pendingCyclesOver >= total) {
+		*counter = start;
+		return false;
+	}
+
+	for (n = 1; n < CROSSBAR_BATCH_MAX; n++)
+		total += Crossbar_Batch_NextCycles(cycles, decimal, counter);
+	total -= *pendingCyclesOver;
+	*pendingCyclesOver = 0;
+
+	batch->ticks = n;
+	batch->counter = start;
+	batch->end = Cycles_GetClockCounterImmediate() + total;
+	CycInt_AddRelativeInterrupt(total, INT_CPU_CYCLE, handler);
+	return true;
+}
+
+/**
+ * End the batch of one clock: run the ticks that are already due and
+ * move its interrupt back to the next tick.
+ */
+static void Crossbar_Batch_SplitClock(struct batch_s *batch, interrupt_id handler,
+                                      uint32_t cycles, uint32_t decimal, uint32_t *counter)
+{
+	uint64_t time;
+	uint32_t total, done, c, i;
+
+	if (batch->ticks <= 1)
+		return;
+
+	/* Time of the tick before the batch */
+	c = batch->counter;
+	total = 0;
+	for (i = 0; i < batch->ticks; i++)
+		total += Crossbar_Batch_NextCycles(cycles, decimal, &c);
+	time = batch->end - total;
+
+	/* Count the ticks an interrupt per tick would already have processed */
+	c = batch->counter;
+	time += Crossbar_Batch_NextCycles(cycles, decimal, &c);
+	done = 0;
+	while (done + 1 < batch->ticks && time <= CyclesGlobalClockCounter) {
+		done++;
+		time += Crossbar_Batch_NextCycles(cycles, decimal, &c);
+	}
+
+	if (handler == INTERRUPT_CROSSBAR_25MHZ)
+		Crossbar_Batch_AdcTicks(done);
+
+	*counter = c;
+	if (done + 1 < batch->ticks) {
+		CycInt_ModifyInterrupt((int)((int64_t)time - (int64_t)batch->end), INT_CPU_CYCLE, handler);
+		batch->end = time;
+	}
+	batch->ticks = 1;
+}
+
+/**
+ * Return both clocks to one interrupt per tick.
+ */
+static void Crossbar_Batch_Split(void)
+{
+	Crossbar_Batch_SplitClock(&batch25, INTERRUPT_CROSSBAR_25MHZ, crossbar.clock25_cycles,
+	                          crossbar.clock25_cycles_decimal, &crossbar.clock25_cycles_counter);
+	Crossbar_Batch_SplitClock(&batch32, INTERRUPT_CROSSBAR_32MHZ, crossbar.clock32_cycles,
+	                          crossbar.clock32_cycles_decimal, &crossbar.clock32_cycles_counter);
+}
+#endif
+
 /**
  * Start internal 25 Mhz clock interrupt.
  */
@@ -1368,6 +1554,13 @@ static void Crossbar_Start_InterruptHandler_25Mhz(void)
 {
 	uint32_t cycles_25;
 
+#ifdef __LIBRETRO__
+	if (Crossbar_Batch_Start(&batch25, CROSSBAR_FREQ_25MHZ, INTERRUPT_CROSSBAR_25MHZ,
+	                         crossbar.clock25_cycles, crossbar.clock25_cycles_decimal,
+	                         &crossbar.clock25_cycles_counter, &crossbar.pendingCyclesOver25))
+		return;
+#endif
+
 //fprintf ( stderr , "start int25 %x %x %x %x\n" , crossbar.clock25_cycles, crossbar.clock25_cycles_counter, crossbar.clock25_cycles_decimal, crossbar.pendingCyclesOver25 );
 	cycles_25 = crossbar.clock25_cycles;
 	crossbar.clock25_cycles_counter += crossbar.clock25_cycles_decimal;
@@ -1396,6 +1589,13 @@ static void Crossbar_Start_InterruptHandler_32Mhz(void)
 {
 	uint32_t cycles_32;
 
+#ifdef __LIBRETRO__
+	if (Crossbar_Batch_Start(&batch32, CROSSBAR_FREQ_32MHZ, INTERRUPT_CROSSBAR_32MHZ,
+	                         crossbar.clock32_cycles, crossbar.clock32_cycles_decimal,
+	                         &crossbar.clock32_cycles_counter, &crossbar.pendingCyclesOver32))
+		return;
+#endif
+
 //fprintf ( stderr , "start int32 %x %x %x %x\n" , crossbar.clock32_cycles, crossbar.clock32_cycles_counter, crossbar.clock32_cycles_decimal, crossbar.pendingCyclesOver32 );
 	cycles_32 = crossbar.clock32_cycles;
 	crossbar.clock32_cycles_counter += crossbar.clock32_cycles_decimal;
@@ -1430,6 +1630,13 @@ void Crossbar_InterruptHandler_25Mhz(void)
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
 
+#ifdef __LIBRETRO__
+	/* The ticks of a batch before this one only advance the ADC */
+	Crossbar_Batch_AdcTicks(batch25.ticks - 1);
+	batch25.ticks = 1;
+	DSP_Sync();
+#endif
+
 	/* If transfer mode is in Ste mode, use only this clock for all the transfers */
 	if (crossbar.isInSteFreqMode) {
 		Crossbar_Process_DSPXmit_Transfer();
@@ -1469,6 +1676,12 @@ void Crossbar_InterruptHandler_32Mhz(void)
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
 
+#ifdef __LIBRETRO__
+	/* The ticks of a batch before this one did nothing */
+	batch32.ticks = 1;
+	DSP_Sync();
+#endif
+
 	/* If transfer mode is in Ste mode, don't use this clock for all the transfers */
 	if (crossbar.isInSteFreqMode) {
 		/* Restart the 32 Mhz clock interrupt */
@@ -60,6 +60,20 @@ static const char* x_ext_memory_addr_name[] = {
 };
 
 static int32_t save_cycles;
+
+#ifdef __LIBRETRO__
+/* While the CPU has the host interrupts disabled, nothing the DSP does can
+ * be seen until the CPU accesses the host port or the crossbar exchanges
+ * SSI data with it. DSP_Run then only accumulates save_cycles, and
+ * DSP_Sync() runs them at those points, or once DSP_DEFER_CYCLES are due.
+ * The DSP executes the same instructions with the same inputs either way. */
+#define DSP_DEFER_CYCLES	8192
+
+static bool bDspNoHostIrq;	/* DSP is executing with host interrupts disabled */
+
+static bool DSP_CanDefer(void);
+static void DSP_Execute(void);
+#endif
 #endif
 
 static bool bDspDebugging;
@@ -79,6 +93,12 @@ static void DSP_TriggerHostInterrupt(int hreq)
 //fprintf ( stderr, "DSP_TriggerHostInterrupt %d %x %x\n" , hreq , regs.sr , regs.intmask );
 
 // TODO [NP] : we should change GPIP bit 3 in MFP instead of using additional SPCFLAG_DSP and DSP_GetHREQ
+#ifdef __LIBRETRO__
+	/* Host interrupts are disabled, so HREQ stays clear: nothing to update */
+	if ( !hreq && bDspNoHostIrq && !bDspHostInterruptPending )
+		return;
+#endif
+
 	if ( hreq )
 	{
 		M68000_SetSpecial(SPCFLAG_DSP);			// TODO for old cpu core, remove, use level 6 instead and M68000_Update_intlev()
@@ -177,6 +197,10 @@ void DSP_UnInit(void)
 void DSP_Reset(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	/* Deferred cycles may still write to DSP memory, which reset keeps */
+	DSP_Sync();
+#endif
 	dsp_core_reset();
 	DSP_TriggerHostInterrupt ( 0 );				/* Clear HREQ */
 	save_cycles = 0;
@@ -205,6 +229,9 @@ void DSP_Enable(void)
 void DSP_Disable(void)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	DSP_Sync();
+#endif
 	bDspEnabled = false;
 #endif
 }
@@ -216,9 +243,18 @@ void DSP_Disable(void)
 void DSP_MemorySnapShot_Capture(bool bSave)
 {
 #if ENABLE_DSP_EMU
+#ifdef __LIBRETRO__
+	/* Savestates hold no deferred cycles */
+	if (bSave)
+		DSP_Sync();
+#endif
 	MemorySnapShot_Store(&bDspEnabled, sizeof(bDspEnabled));
 	MemorySnapShot_Store(&dsp_core, sizeof(dsp_core));
 	MemorySnapShot_Store(&save_cycles, sizeof(save_cycles));
+#ifdef __LIBRETRO__
+	if (!bSave)
+		dsp56k_flush_decoded();
+#endif
 
 	if ( bDspEnabled )
 		DSP_Enable();
@@ -246,6 +282,12 @@ void DSP_Run(int nHostCycles)
 	if (save_cycles <= 0)
 		return;
 
+#ifdef __LIBRETRO__
+	if (save_cycles < DSP_DEFER_CYCLES && DSP_CanDefer())
+		return;
+
+	DSP_Execute();
+#else
 	if (unlikely(bDspDebugging))
 	{
 		while (save_cycles > 0)
@@ -264,9 +306,66 @@ void DSP_Run(int nHostCycles)
 			save_cycles -= dsp_core.instr_cycle;
 		}
 	}
+#endif
+
+#endif
+}
+
+#ifdef __LIBRETRO__
+#if ENABLE_DSP_EMU
+/**
+ * True while the CPU can not receive a host interrupt from the DSP.
+ * Only the CPU changes this, and it always calls DSP_Sync() first.
+ */
+static bool DSP_CanDefer(void)
+{
+	return !bDspDebugging && !bDspHostInterruptPending &&
+		!(dsp_core.hostport[CPU_HOST_ICR] & ((1<<CPU_HOST_ICR_RREQ)|(1<<CPU_HOST_ICR_TREQ)));
+}
+
+/**
+ * Execute the DSP until save_cycles are spent
+ */
+static void DSP_Execute(void)
+{
+	bDspNoHostIrq = DSP_CanDefer();
+
+	if (unlikely(bDspDebugging))
+	{
+		while (save_cycles > 0)
+		{
+			dsp56k_execute_instruction();
+			save_cycles -= dsp_core.instr_cycle;
+			DebugDsp_Check();
+		}
+	}
+	else
+	{
+		while (save_cycles > 0)
+		{
+			dsp56k_execute_instruction();
+			save_cycles -= dsp_core.instr_cycle;
+		}
+	}
 
+	bDspNoHostIrq = false;
+}
+#endif
+
+/**
+ * Run the DSP cycles deferred by DSP_Run, before anything else looks at
+ * the DSP or hands it new input.
+ */
+void DSP_Sync(void)
+{
+#if ENABLE_DSP_EMU
+	if (dsp_core.running == 0 || save_cycles <= 0)
+		return;
+
+	DSP_Execute();
 #endif
 }
+#endif
 
 /**
  * Enable/disable DSP debugging mode
@@ -841,6 +940,10 @@ void DSP_HandleReadAccess(void)
 	uint8_t value;
 	bool multi_access = false;
 
+#ifdef __LIBRETRO__
+	DSP_Sync();
+#endif
+
 	for (addr = IoAccessBaseAddress; addr < IoAccessBaseAddress+nIoMemAccessSize; addr++)
 	{
 #if ENABLE_DSP_EMU
@@ -868,6 +971,10 @@ void DSP_HandleWriteAccess(void)
 	uint32_t addr;
 	bool multi_access = false;
 
+#ifdef __LIBRETRO__
+	DSP_Sync();
+#endif
+
 	for (addr = IoAccessBaseAddress; addr < IoAccessBaseAddress+nIoMemAccessSize; addr++)
 	{
 #if ENABLE_DSP_EMU
@@ -123,6 +123,23 @@ static uint16_t disasm_memory_ptr;		/* Pointer for memory change in disasm mode
 
 typedef void (*dsp_emul_t)(void);
 
+#ifdef __LIBRETRO__
+/* Decoded instruction cache: the instruction word and its fully resolved
+ * handler for every P memory location, laid out like the internal and
+ * external RAM they mirror. Writes to P memory (including the X/Y aliases
+ * of external RAM) clear the matching entry, anything that replaces
+ * dsp_core as a whole flushes the cache. */
+typedef struct {
+	uint32_t inst;
+	dsp_emul_t func;	/* NULL: not decoded yet */
+} dsp_decoded_t;
+
+static dsp_decoded_t decoded_int[0x200];
+static dsp_decoded_t decoded_ext[DSP_RAMSIZE];
+
+static dsp_emul_t dsp_decode_instruction(uint32_t inst);
+#endif
+
 static void dsp_postexecute_update_pc(void);
 static void dsp_postexecute_interrupts(void);
 
@@ -707,6 +724,9 @@ void dsp56k_init_cpu(void)
 {
 	dsp56k_disasm_init();
 	isDsp_in_disasm_mode = false;
+#ifdef __LIBRETRO__
+	dsp56k_flush_decoded();
+#endif
 #if DSP_COUNT_IPS
 	start_time = SDL_GetTicks();
 	num_inst = 0;
@@ -744,6 +764,9 @@ uint16_t dsp56k_execute_one_disasm_instruction(FILE *out, uint16_t pc)
 
 	/* Restore DSP context after executing instruction */
 	memcpy(ptr1, ptr2, sizeof(dsp_core));
+#ifdef __LIBRETRO__
+	dsp56k_flush_decoded();
+#endif
 
 	/* Unset DSP in disasm mode */
 	isDsp_in_disasm_mode = false;
@@ -755,6 +778,9 @@ void dsp56k_execute_instruction(void)
 {
 	uint32_t value;
 	uint32_t disasm_return = 0;
+#ifdef __LIBRETRO__
+	dsp_decoded_t *decoded;
+#endif
 	disasm_memory_ptr = 0;
 
 	/* Initialise the number of access to the external memory for this instruction */
@@ -769,7 +795,21 @@ void dsp56k_execute_instruction(void)
 	}
 
 	/* Decode and execute current instruction */
+#ifdef __LIBRETRO__
+	if (dsp_core.pc < 0x200) {
+		decoded = &decoded_int[dsp_core.pc];
+	} else {
+		access_to_ext_memory |= 1 << DSP_SPACE_P;
+		decoded = &decoded_ext[dsp_core.pc & (DSP_RAMSIZE-1)];
+	}
+	if (decoded->func == NULL) {
+		decoded->inst = read_memory_p(dsp_core.pc);
+		decoded->func = dsp_decode_instruction(decoded->inst);
+	}
+	cur_inst = decoded->inst;
+#else
 	cur_inst = read_memory_p(dsp_core.pc);
+#endif
 
 	/* Initialize instruction size and cycle counter */
 	cur_inst_len = 1;
@@ -789,6 +829,9 @@ void dsp56k_execute_instruction(void)
 		}
 	}
 
+#ifdef __LIBRETRO__
+	decoded->func();
+#else
 	if (cur_inst < 0x100000) {
 		value = (cur_inst >> 11) & (BITMASK(6) << 3);
 		value += (cur_inst >> 5) & BITMASK(3);
@@ -797,6 +840,7 @@ void dsp56k_execute_instruction(void)
 		/* Do parallel move read */
 		opcodes_parmove[(cur_inst>>20) & BITMASK(4)]();
 	}
+#endif
 
 	/* Add the waitstate due to external memory access */
 	/* (2 extra cycles per extra access to the external memory after the first one */
@@ -855,6 +899,59 @@ void dsp56k_execute_instruction(void)
 #endif
 }
 
+#ifdef __LIBRETRO__
+/**********************************
+ *	Decoded instruction cache
+**********************************/
+
+/* Resolve the handler for an instruction word, including the sub-decoding
+ * dsp_pm_2 and dsp_pm_4 would otherwise repeat on every execution */
+static dsp_emul_t dsp_decode_instruction(uint32_t inst)
+{
+	uint32_t value;
+
+	if (inst < 0x100000) {
+		value = (inst >> 11) & (BITMASK(6) << 3);
+		value += (inst >> 5) & BITMASK(3);
+		return opcodes8h[value];
+	}
+
+	switch ((inst>>20) & BITMASK(4)) {
+		case 2:
+			/* nop: the ALU instruction alone */
+			if ((inst & 0xffff00) == 0x200000)
+				return opcodes_alu[inst & BITMASK(8)];
+			if ((inst & 0xffe000) == 0x204000)
+				return dsp_pm_2;
+			if ((inst & 0xfc0000) == 0x200000)
+				return dsp_pm_2_2;
+			return dsp_pm_3;
+		case 4:
+			if ((inst & 0xf40000) == 0x400000)
+				return dsp_pm_4x;
+			return dsp_pm_5;
+	}
+	return opcodes_parmove[(inst>>20) & BITMASK(4)];
+}
+
+/* Forget the decoded instruction at a P memory address */
+void dsp56k_invalidate_decoded(uint16_t address)
+{
+	if (address < 0x200) {
+		decoded_int[address].func = NULL;
+	} else {
+		decoded_ext[address & (DSP_RAMSIZE-1)].func = NULL;
+	}
+}
+
+/* Forget all decoded instructions, when dsp_core has been replaced */
+void dsp56k_flush_decoded(void)
+{
+	memset(decoded_int, 0, sizeof(decoded_int));
+	memset(decoded_ext, 0, sizeof(decoded_ext));
+}
+#endif
+
 /**********************************
  *	Update the PC
 **********************************/
@@ -1375,6 +1472,10 @@ static void write_memory_raw(int space, uint16_t address, uint32_t value)
 	/* Internal RAM ? */
 	if (address < 0x100) {
 		dsp_core.ramint[space][address] = value;
+#ifdef __LIBRETRO__
+		if (space == DSP_SPACE_P)
+			decoded_int[address].func = NULL;
+#endif
 		return;
 	}
 
@@ -1389,6 +1490,9 @@ static void write_memory_raw(int space, uint16_t address, uint32_t value)
 		else {
 			/* Space P RAM */
 			dsp_core.ramint[DSP_SPACE_P][address] = value;
+#ifdef __LIBRETRO__
+			decoded_int[address].func = NULL;
+#endif
 			return;
 		}
 	}
@@ -1410,6 +1514,9 @@ static void write_memory_raw(int space, uint16_t address, uint32_t value)
 
 	/* Falcon: External RAM, map X,Y to P */
 	dsp_core.ramext[address & (DSP_RAMSIZE-1)] = value;
+#ifdef __LIBRETRO__
+	decoded_ext[address & (DSP_RAMSIZE-1)].func = NULL;
+#endif
 }
 
 static void write_memory_disasm(int space, uint16_t address, uint32_t value)
@@ -1023,6 +1023,17 @@ bool VIDEL_renderScreen(void)
 		return false;
 	}
 
+#ifdef __LIBRETRO__
+	/* nothing to draw, but the palette is synced as usual because it is saved with the state */
+	if (ConfigureParams.Screen.DisableVideo) {
+		VIDEL_UpdateColors();
+		return false;
+	}
+
+	/* unchanged lines are not redrawn, so the overlay led must be removed */
+	Statusbar_OverlayRestore(sdlscrn);
+#endif
+
 	if (!Screen_Lock())
 		return false;
 
@@ -1052,6 +1063,9 @@ bool VIDEL_renderScreen(void)
 	                  videl.upperBorderSize, videl.lowerBorderSize);
 
 	Screen_UnLock();
+#ifdef __LIBRETRO__
+	Statusbar_OverlayBackup(sdlscrn);
+#endif
 	Screen_GenConvUpdate(Statusbar_Update(sdlscrn, false), false);
 
 	return true;
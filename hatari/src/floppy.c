@@ -44,6 +44,7 @@ const char Floppy_fileid[] = "Hatari floppy.c";
 #include "str.h"
 #include "video.h"
 #include "fdc.h"
+#include "utils.h"
 
 
 /* Emulation drive details, eg FileName, Inserted, Changed etc... */
@@ -72,7 +73,24 @@ static void	Floppy_DriveTransitionSetState ( int Drive , int State );
 
 #ifdef __LIBRETRO__
 extern bool core_savestate_floppy_modify;
+extern bool core_savestate_local;
+extern bool bCaptureError;
+extern uint32_t core_rand_seed;
 static bool core_prevent_eject_save = false;
+
+/* Savestate size is fixed at load, leave room to modify a disk at least this large (1.44MB high density) */
+#define FLOPPY_SNAPSHOT_RESERVE_BYTES	(2 * 80 * 18 * NUMBYTESPERSECTOR)
+
+/* Copy of the image last inserted in each drive, savestates only store the sectors that differ from it */
+static uint8_t *Floppy_Base[MAX_FLOPPYDRIVES] = { NULL, NULL };
+static int Floppy_BaseBytes[MAX_FLOPPYDRIVES] = { 0, 0 };
+static int Floppy_BaseType[MAX_FLOPPYDRIVES] = { FLOPPY_IMAGE_TYPE_NONE, FLOPPY_IMAGE_TYPE_NONE };
+static uint64_t Floppy_BaseHash[MAX_FLOPPYDRIVES] = { 0, 0 };	/* hash of the image file in the core's disk list, 0 if restored from a savestate */
+static uint8_t *Floppy_SectorDirty[MAX_FLOPPYDRIVES] = { NULL, NULL };	/* 1 for each sector written since insertion */
+
+static void	Floppy_SetBase(int Drive, uint64_t nHash);
+static void	Floppy_MarkSectorsDirty(int Drive, long Offset, int Count);
+static void	Floppy_MemorySnapShot_Image(int Drive, bool bSave);
 #endif
 
 /*-----------------------------------------------------------------------*/
@@ -101,6 +119,20 @@ void Floppy_Init(void)
 void Floppy_UnInit(void)
 {
 	Floppy_EjectBothDrives();
+#ifdef __LIBRETRO__
+	{
+		int i;
+		for (i = 0; i < MAX_FLOPPYDRIVES; i++)
+		{
+			free(Floppy_Base[i]);
+			free(Floppy_SectorDirty[i]);
+			Floppy_Base[i] = NULL;
+			Floppy_SectorDirty[i] = NULL;
+			Floppy_BaseBytes[i] = 0;
+			Floppy_BaseType[i] = FLOPPY_IMAGE_TYPE_NONE;
+		}
+	}
+#endif
 }
 
 
@@ -129,22 +161,18 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 {
 	int i;
 
+#ifndef __LIBRETRO__
 	/* If restoring then eject old drives first! */
 	if (!bSave)
-#ifdef __LIBRETRO__
-	{
-		// if savety save is disabled, prevent the savestate restore write to disk
-		if (!core_savestate_floppy_modify) core_prevent_eject_save = true;
-		Floppy_EjectBothDrives();
-		core_prevent_eject_save = false;
-	}
-#else	
 		Floppy_EjectBothDrives();
+#else
+	/* Drives are ejected only when their image can't be reused, see Floppy_MemorySnapShot_Image */
 #endif
 
 	/* Save/Restore details */
 	for (i = 0; i < MAX_FLOPPYDRIVES; i++)
 	{
+#ifndef __LIBRETRO__
 		MemorySnapShot_Store(&EmulationDrives[i].ImageType, sizeof(EmulationDrives[i].ImageType));
 		MemorySnapShot_Store(&EmulationDrives[i].bDiskInserted, sizeof(EmulationDrives[i].bDiskInserted));
 		MemorySnapShot_Store(&EmulationDrives[i].nImageBytes, sizeof(EmulationDrives[i].nImageBytes));
@@ -156,10 +184,9 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 		}
 		if (EmulationDrives[i].pBuffer)
 			MemorySnapShot_Store(EmulationDrives[i].pBuffer, EmulationDrives[i].nImageBytes);
-#ifndef __LIBRETRO__
 		MemorySnapShot_Store(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
 #else
-		MemorySnapShot_StoreFilename(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
+		Floppy_MemorySnapShot_Image(i, bSave);
 #endif
 		MemorySnapShot_Store(&EmulationDrives[i].bContentsChanged,sizeof(EmulationDrives[i].bContentsChanged));
 		MemorySnapShot_Store(&EmulationDrives[i].bOKToSave,sizeof(EmulationDrives[i].bOKToSave));
@@ -570,6 +597,8 @@ void core_floppy_eject(int drive)
 	Floppy_SetDiskFileNameNone(drive);
 	floppy_data[drive] = NULL;
 	floppy_size[drive] = 0;
+	floppy_extra_data[drive] = NULL;
+	floppy_extra_size[drive] = 0;
 }
 bool core_floppy_file_extra(void)
 {
@@ -599,6 +628,309 @@ void core_floppy_changed(int drive)
 {
 	EmulationDrives[drive].bContentsChanged = true;
 }
+
+/**
+ * Hash of an image file and its optional extra file, identifies the image in savestates.
+ */
+static uint64_t Floppy_ImageHash(const void *data, unsigned int size, const void *extra_data, unsigned int extra_size)
+{
+	uint64_t nHash = hash64(data, size);
+	if (extra_data)
+		nHash ^= hash64(extra_data, extra_size) * 31;
+	return nHash;
+}
+
+/**
+ * Number of sectors of an image, the last one may be incomplete for non sector based formats.
+ */
+static uint32_t Floppy_SectorCount(int nImageBytes)
+{
+	return ( nImageBytes + NUMBYTESPERSECTOR - 1 ) / NUMBYTESPERSECTOR;
+}
+
+static int Floppy_SectorBytes(int nImageBytes, uint32_t nSector)
+{
+	int nBytes = nImageBytes - nSector * NUMBYTESPERSECTOR;
+	return nBytes < NUMBYTESPERSECTOR ? nBytes : NUMBYTESPERSECTOR;
+}
+
+/**
+ * Largest image a savestate needs room for: a high density disk,
+ * the image currently in the drive, or any file in the core's disk list.
+ */
+static int Floppy_SnapShotMaxBytes(int Drive)
+{
+	const char *filename;
+	void *data, *extra_data;
+	unsigned int size, extra_size, i;
+	int nMax = FLOPPY_SNAPSHOT_RESERVE_BYTES;
+
+	if (EmulationDrives[Drive].bDiskInserted && EmulationDrives[Drive].nImageBytes > nMax)
+		nMax = EmulationDrives[Drive].nImageBytes;
+	for (i = 0; core_disk_get_image(i, &filename, &data, &size, &extra_data, &extra_size); i++)
+	{
+		if (data && (int)size > nMax)
+			nMax = size;
+	}
+	return nMax;
+}
+
+/**
+ * Keep a copy of the image that was just inserted, and the hash of its file.
+ */
+static void Floppy_SetBase(int Drive, uint64_t nHash)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+
+	if (Floppy_BaseBytes[Drive] != pDrive->nImageBytes || Floppy_Base[Drive] == NULL)
+	{
+		free(Floppy_Base[Drive]);
+		free(Floppy_SectorDirty[Drive]);
+		Floppy_Base[Drive] = malloc(pDrive->nImageBytes);
+		Floppy_SectorDirty[Drive] = malloc(Floppy_SectorCount(pDrive->nImageBytes));
+	}
+	if (Floppy_Base[Drive] == NULL || Floppy_SectorDirty[Drive] == NULL)
+	{
+		free(Floppy_Base[Drive]);
+		free(Floppy_SectorDirty[Drive]);
+		Floppy_Base[Drive] = NULL;
+		Floppy_SectorDirty[Drive] = NULL;
+		Floppy_BaseBytes[Drive] = 0;
+		Floppy_BaseType[Drive] = FLOPPY_IMAGE_TYPE_NONE;
+		return;
+	}
+	memcpy(Floppy_Base[Drive], pDrive->pBuffer, pDrive->nImageBytes);
+	memset(Floppy_SectorDirty[Drive], 0, Floppy_SectorCount(pDrive->nImageBytes));
+	Floppy_BaseBytes[Drive] = pDrive->nImageBytes;
+	Floppy_BaseType[Drive] = pDrive->ImageType;
+	Floppy_BaseHash[Drive] = nHash;
+}
+
+/**
+ * Mark sectors written by Floppy_WriteSectors.
+ */
+static void Floppy_MarkSectorsDirty(int Drive, long Offset, int Count)
+{
+	uint32_t nSector = Offset / NUMBYTESPERSECTOR;
+	uint32_t nSectors = Floppy_SectorCount(Floppy_BaseBytes[Drive]);
+
+	if (Floppy_SectorDirty[Drive] == NULL)
+		return;
+	for (; Count > 0 && nSector < nSectors; Count--, nSector++)
+		Floppy_SectorDirty[Drive][nSector] = 1;
+}
+
+/**
+ * Find the image of a savestate in the core's disk list, and insert it to make it the drive's base.
+ * Return true if found.
+ */
+static bool Floppy_InsertFromCore(int Drive, const char *pszFileName, uint64_t nHash)
+{
+	const char *filename;
+	void *data, *extra_data;
+	unsigned int size, extra_size, i;
+	uint32_t seed_temp = core_rand_seed; /* FDC_InsertFloppy may modify it, prevent a divergence */
+	bool bFound = false;
+
+	for (i = 0; !bFound && core_disk_get_image(i, &filename, &data, &size, &extra_data, &extra_size); i++)
+	{
+		if (data == NULL || strcmp(filename, pszFileName))
+			continue;
+		if (Floppy_ImageHash(data, size, extra_data, extra_size) != nHash)
+			continue;
+		bFound = core_floppy_insert(Drive, filename, data, size, extra_data, extra_size);
+		core_prevent_eject_save = true;
+		Floppy_EjectDiskFromDrive(Drive);
+		core_prevent_eject_save = false;
+	}
+	core_rand_seed = seed_temp;
+	return bFound;
+}
+
+/**
+ * Save/Restore the image in a drive.
+ * Instead of the whole image, only its hash and the sectors that differ from the inserted file are stored.
+ * A modified image is stored whole unless the savestate stays in this instance,
+ * its file may since have been written back and no longer match the hash.
+ * On restore, the image buffer is reused if the same image is still in the drive.
+ */
+static void Floppy_MemorySnapShot_Image(int Drive, bool bSave)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+	int ImageType = pDrive->ImageType;
+	bool bDiskInserted = pDrive->bDiskInserted;
+	int nImageBytes = pDrive->nImageBytes;
+	uint64_t nHash = Floppy_BaseHash[Drive];
+	char sFileName[FILENAME_MAX];
+	uint32_t nCount, nSector, nSectors, i;
+	uint8_t bEmbed = 0;
+	bool bBaseMatch, bReuse;
+
+	MemorySnapShot_Store(&ImageType, sizeof(ImageType));
+	MemorySnapShot_Store(&bDiskInserted, sizeof(bDiskInserted));
+	MemorySnapShot_Store(&nImageBytes, sizeof(nImageBytes));
+	if (bSave)
+		strcpy(sFileName, pDrive->sFileName);
+	MemorySnapShot_StoreFilename(sFileName, sizeof(sFileName));
+	MemorySnapShot_Store(&nHash, sizeof(nHash));
+	nSectors = bDiskInserted ? Floppy_SectorCount(nImageBytes) : 0;
+
+	if (bSave && core_snapshot_size_query)
+	{
+		/* every sector of the largest disk could be modified, this also leaves room for an embedded image */
+		nCount = Floppy_SectorCount(Floppy_SnapShotMaxBytes(Drive));
+		MemorySnapShot_Store(&bEmbed, sizeof(bEmbed));
+		MemorySnapShot_Store(&nCount, sizeof(nCount));
+		MemorySnapShot_Skip(nCount * (sizeof(nSector) + NUMBYTESPERSECTOR));
+		return;
+	}
+	if (bSave)
+	{
+		nCount = 0;
+		if (bDiskInserted && Floppy_SectorDirty[Drive])
+		{
+			/* forget written sectors that were not actually changed */
+			for (i = 0; i < nSectors; i++)
+			{
+				if (Floppy_SectorDirty[Drive][i])
+				{
+					if (memcmp(pDrive->pBuffer + i * NUMBYTESPERSECTOR, Floppy_Base[Drive] + i * NUMBYTESPERSECTOR, Floppy_SectorBytes(nImageBytes, i)))
+						nCount++;
+					else
+						Floppy_SectorDirty[Drive][i] = 0;
+				}
+			}
+		}
+		bEmbed = ( bDiskInserted && pDrive->pBuffer && !core_savestate_local && ( nCount > 0 || pDrive->bContentsChanged ) ) ? 1 : 0;
+		MemorySnapShot_Store(&bEmbed, sizeof(bEmbed));
+		if (bEmbed)
+		{
+			MemorySnapShot_Store(pDrive->pBuffer, nImageBytes);
+			return;
+		}
+		MemorySnapShot_Store(&nCount, sizeof(nCount));
+		for (i = 0; i < nSectors && nCount > 0; i++)
+		{
+			if (Floppy_SectorDirty[Drive][i])
+			{
+				nSector = i;
+				MemorySnapShot_Store(&nSector, sizeof(nSector));
+				MemorySnapShot_Store(pDrive->pBuffer + i * NUMBYTESPERSECTOR, Floppy_SectorBytes(nImageBytes, i));
+				--nCount;
+			}
+		}
+		return;
+	}
+
+	bBaseMatch = bDiskInserted && Floppy_Base[Drive] && Floppy_BaseHash[Drive] == nHash
+		&& Floppy_BaseBytes[Drive] == nImageBytes && Floppy_BaseType[Drive] == ImageType;
+	/* IPF and STX are re-inserted by their own snapshot functions, they need an ejected drive. */
+	/* A modified disk must be ejected to be written back if the safety save is enabled. */
+	bReuse = bBaseMatch && pDrive->bDiskInserted && pDrive->pBuffer
+		&& ( ImageType == FLOPPY_IMAGE_TYPE_ST || ImageType == FLOPPY_IMAGE_TYPE_MSA || ImageType == FLOPPY_IMAGE_TYPE_DIM )
+		&& !( pDrive->bContentsChanged && core_savestate_floppy_modify );
+
+	if (!bReuse)
+	{
+		// if savety save is disabled, prevent the savestate restore write to disk
+		if (!core_savestate_floppy_modify) core_prevent_eject_save = true;
+		Floppy_EjectDiskFromDrive(Drive);
+		core_prevent_eject_save = false;
+		if (bDiskInserted && !bBaseMatch && Floppy_InsertFromCore(Drive, sFileName, nHash))
+		{
+			bBaseMatch = Floppy_Base[Drive] && Floppy_BaseHash[Drive] == nHash
+				&& Floppy_BaseBytes[Drive] == nImageBytes && Floppy_BaseType[Drive] == ImageType;
+		}
+	}
+
+	MemorySnapShot_Store(&bEmbed, sizeof(bEmbed));
+	if (bEmbed && bDiskInserted)
+	{
+		if (!bReuse)
+			pDrive->pBuffer = malloc(nImageBytes);
+		if (!pDrive->pBuffer)
+		{
+			core_error_msg("Savestate floppy image could not be allocated.");
+			bCaptureError = true;
+			MemorySnapShot_Skip(nImageBytes);
+			return;
+		}
+		MemorySnapShot_Store(pDrive->pBuffer, nImageBytes);
+		strcpy(pDrive->sFileName, sFileName);
+		pDrive->ImageType = ImageType;
+		pDrive->nImageBytes = nImageBytes;
+		pDrive->bDiskInserted = true;
+		if (bBaseMatch)
+		{
+			/* the file is still available, keep it as the base of later incremental savestates */
+			for (i = 0; i < nSectors; i++)
+				Floppy_SectorDirty[Drive][i] = memcmp(pDrive->pBuffer + i * NUMBYTESPERSECTOR, Floppy_Base[Drive] + i * NUMBYTESPERSECTOR, Floppy_SectorBytes(nImageBytes, i)) ? 1 : 0;
+		}
+		else
+		{
+			/* no longer matches any file, the embedded image becomes the base */
+			Floppy_SetBase(Drive, 0);
+		}
+		return;
+	}
+
+	MemorySnapShot_Store(&nCount, sizeof(nCount));
+	if (!bDiskInserted)
+		return;
+
+	if (bBaseMatch && !bReuse)
+	{
+		pDrive->pBuffer = malloc(nImageBytes);
+		if (pDrive->pBuffer)
+		{
+			memcpy(pDrive->pBuffer, Floppy_Base[Drive], nImageBytes);
+			memset(Floppy_SectorDirty[Drive], 0, nSectors);
+		}
+	}
+	if (!bBaseMatch || !pDrive->pBuffer || nCount > nSectors)
+	{
+		static char floppy_error_msg[FILENAME_MAX+64];
+		snprintf(floppy_error_msg, sizeof(floppy_error_msg), "Savestate floppy image not found: %s", sFileName);
+		core_error_msg(floppy_error_msg);
+		bCaptureError = true;
+		for (i = 0; i < nCount && i < nSectors; i++)
+		{
+			MemorySnapShot_Store(&nSector, sizeof(nSector));
+			MemorySnapShot_Skip(Floppy_SectorBytes(nImageBytes, nSector < nSectors ? nSector : 0));
+		}
+		return;
+	}
+
+	if (bReuse)
+	{
+		/* revert the sectors written since the savestate */
+		for (i = 0; i < nSectors; i++)
+		{
+			if (Floppy_SectorDirty[Drive][i])
+			{
+				memcpy(pDrive->pBuffer + i * NUMBYTESPERSECTOR, Floppy_Base[Drive] + i * NUMBYTESPERSECTOR, Floppy_SectorBytes(nImageBytes, i));
+				Floppy_SectorDirty[Drive][i] = 0;
+			}
+		}
+	}
+	for (i = 0; i < nCount; i++)
+	{
+		MemorySnapShot_Store(&nSector, sizeof(nSector));
+		if (nSector >= nSectors)
+		{
+			core_error_msg("Savestate floppy sector out of range.");
+			bCaptureError = true;
+			return;
+		}
+		MemorySnapShot_Store(pDrive->pBuffer + nSector * NUMBYTESPERSECTOR, Floppy_SectorBytes(nImageBytes, nSector));
+		Floppy_SectorDirty[Drive][nSector] = 1;
+	}
+
+	strcpy(pDrive->sFileName, sFileName);
+	pDrive->ImageType = ImageType;
+	pDrive->nImageBytes = nImageBytes;
+	pDrive->bDiskInserted = true;
+}
 #endif
 
 /*-----------------------------------------------------------------------*/
@@ -690,6 +1022,9 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 	EmulationDrives[Drive].nImageBytes = nImageBytes;
 	EmulationDrives[Drive].bDiskInserted = true;
 	EmulationDrives[Drive].bContentsChanged = false;
+#ifdef __LIBRETRO__
+	Floppy_SetBase(Drive, Floppy_ImageHash(floppy_data[Drive], floppy_size[Drive], floppy_extra_data[Drive], floppy_extra_size[Drive]));
+#endif
 
 	if ( ( ImageType == FLOPPY_IMAGE_TYPE_ST ) || ( ImageType == FLOPPY_IMAGE_TYPE_MSA )
 	  || ( ImageType == FLOPPY_IMAGE_TYPE_DIM ) )
@@ -1078,6 +1413,9 @@ bool Floppy_WriteSectors(int Drive, uint8_t *pBuffer, uint16_t Sector,
 		memcpy(pDiskBuffer+Offset, pBuffer, (int)Count*NUMBYTESPERSECTOR);
 		/* And set 'changed' flag */
 		EmulationDrives[Drive].bContentsChanged = true;
+#ifdef __LIBRETRO__
+		Floppy_MarkSectorsDirty(Drive, Offset, Count);
+#endif
 
 		return true;
 	}
@@ -3239,6 +3239,10 @@ static bool GemDOS_SNext(void)
 		return true;
 	}
 	pDTA = (DTA *)STMemory_STAddrToPointer(DTA_Gemdos);
+#ifdef __LIBRETRO__
+	/* the DTA is modified directly below, mark it for incremental savestates */
+	STMemory_MarkDirtyPointer(pDTA, sizeof(DTA));
+#endif
 
 	/* Was DTA ours or TOS? */
 	if (do_get_mem_long(pDTA->magic) != DTA_MAGIC_NUMBER)
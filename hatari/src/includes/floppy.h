@@ -73,6 +73,7 @@ extern corefile* core_disk_save_open(const char* filename);
 extern void core_disk_save_close_extra(corefile* file, bool success);
 extern bool core_disk_save_write(const uint8_t* data, unsigned int size, corefile* file);
 extern bool core_disk_save_exists(const char* filename);
+extern bool core_disk_get_image(unsigned int index, const char** filename, void** data, unsigned int* size, void** extra_data, unsigned int* extra_size);
 extern uint8_t* core_read_file_save(const char* filename, unsigned int* size_out);
 extern bool core_write_file_save(const char* filename, unsigned int size, const uint8_t* data);
 extern bool core_disk_enable_save;
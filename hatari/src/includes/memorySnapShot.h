@@ -21,6 +21,18 @@ extern void MemorySnapShot_Restore_Do(void);
 extern bool bCaptureSave;
 inline void MemorySnapShot_Store(void *pData, int Size)
 {
+	// copy directly to/from the savestate buffer,
+	// most fields have a constant size so this becomes a single load and store
+	int end = snapshot_pos + Size;
+	if (snapshot_buffer && end <= snapshot_size)
+	{
+		if (bCaptureSave) memcpy(snapshot_buffer + snapshot_pos, pData, Size);
+		else              memcpy(pData, snapshot_buffer + snapshot_pos, Size);
+		snapshot_pos = end;
+		if (end > snapshot_max) snapshot_max = end;
+		return;
+	}
+	// size measurement or overflow
 	if (bCaptureSave) core_snapshot_write(pData, Size);
   else              core_snapshot_read( pData, Size);
 }
@@ -12,6 +12,10 @@ void Screen_RemapPalette(void);
 void Screen_SetPaletteColor(Uint8 idx, Uint8 red, Uint8 green, Uint8 blue);
 SDL_Color Screen_GetPaletteColor(Uint8 idx);
 void ScreenConv_MemorySnapShot_Capture(bool bSave);
+#ifdef __LIBRETRO__
+void ScreenConv_SetFullUpdate(void);
+bool ScreenConv_Changed(void);
+#endif
 
 void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
                        int vbpp, int nextline, int hscroll,
@@ -53,6 +53,7 @@ extern int	YmVolumeMixing;
 #define		YM2149_LPF_FILTER_PWM			2
 #ifdef __LIBRETRO__
 #define		YM2149_LPF_FILTER_IIR			3
+#define		YM2149_LPF_FILTER_FIR			4
 #endif
 extern int	YM2149_LPF_Filter;
 
@@ -11,7 +11,9 @@
 #include "main.h"
 #include "sysdeps.h"
 #include "maccess.h"
+#ifndef __LIBRETRO__
 #include "memory.h"
+#endif
 
 
 #if ENABLE_SMALL_MEM
@@ -28,6 +30,26 @@ extern uae_u32 TTmem_size;
 
 extern uint32_t STRamEnd;
 
+#ifdef __LIBRETRO__
+/* Dirty page tracking of the STRam[] array, used by incremental savestates and rewind. */
+/* Every write path into STRam[] must mark its page, offsets are relative to STRam. */
+#define	STMEMORY_PAGE_SHIFT	12
+#define	STMEMORY_PAGE_SIZE	( 1 << STMEMORY_PAGE_SHIFT )
+#define	STMEMORY_PAGE_COUNT	( ( 16*1024*1024 ) >> STMEMORY_PAGE_SHIFT )
+#define	STMEMORY_DIRTY_DELTA	1	/* page may differ from the incremental savestate reference copy */
+#define	STMEMORY_DIRTY_REWIND	2	/* page may differ from the last rewind savestate */
+#define	STMEMORY_DIRTY_ALL	( STMEMORY_DIRTY_DELTA | STMEMORY_DIRTY_REWIND )
+extern uint8_t STMemory_PageDirty[ STMEMORY_PAGE_COUNT + 1 ];	/* +1 for unaligned access at the end of STRam */
+#define	STMemory_MarkDirty(offset)	( STMemory_PageDirty[ ((uint32_t)(offset)) >> STMEMORY_PAGE_SHIFT ] = STMEMORY_DIRTY_ALL )
+#define	STMemory_MarkDirty2(offset,size)	{ STMemory_MarkDirty(offset); STMemory_MarkDirty((offset)+(size)-1); }
+extern void STMemory_MarkDirtyRange ( uint32_t offset , uint32_t len );
+extern void STMemory_MarkDirtyPointer ( const void *p , uint32_t len );
+extern bool STMemory_SkipClear;
+extern void STMemory_RomLoaded ( void );
+
+#include "memory.h"		/* after the dirty page tracking, used by its inline put_xxx() */
+#endif
+
 
 #define	MEM_BANK_SIZE_128	( 128 * 1024 )		/* 00b */
 #define	MEM_BANK_SIZE_512	( 512 * 1024 )		/* 01b */
@@ -19,6 +19,10 @@ extern void	crc32_add_byte		( uint32_t *crc , uint8_t c );
 extern void	crc16_reset		( uint16_t *crc );
 extern void	crc16_add_byte		( uint16_t *crc , uint8_t c );
 
+#ifdef __LIBRETRO__
+extern uint64_t	hash64			( const uint8_t *p , uint32_t len );
+#endif
+
 void		Hatari_srand		( unsigned int seed );
 extern int	Hatari_rand		( void );
 
@@ -298,6 +298,30 @@ void IoMem_Init(void)
 	}
 
 	/* Now set the correct handlers */
+#ifdef __LIBRETRO__
+	/* walk each span instead of scanning the whole list for every address,
+	 * savestate restore calls this so it needs to be quick,
+	 * the result is the same because later entries still overwrite earlier ones */
+	for (i=0; pInterceptAccessFuncs[i].Address != 0; i++)
+	{
+		for (addr = pInterceptAccessFuncs[i].Address;
+		     addr < pInterceptAccessFuncs[i].Address+pInterceptAccessFuncs[i].SpanInBytes && addr <= 0xffffff;
+		     addr++)
+		{
+			if (addr < 0xff8000)
+				continue;
+			/* Security checks... */
+			if (pInterceptReadTable[addr-0xff8000] != IoMem_BusErrorEvenReadAccess && pInterceptReadTable[addr-0xff8000] != IoMem_BusErrorOddReadAccess)
+				Log_Printf(LOG_WARN, "IoMem_Init: $%x (R) already defined\n", addr);
+			if (pInterceptWriteTable[addr-0xff8000] != IoMem_BusErrorEvenWriteAccess && pInterceptWriteTable[addr-0xff8000] != IoMem_BusErrorOddWriteAccess)
+				Log_Printf(LOG_WARN, "IoMem_Init: $%x (W) already defined\n", addr);
+
+			/* This location needs to be intercepted, so add entry to list */
+			pInterceptReadTable[addr-0xff8000] = pInterceptAccessFuncs[i].ReadFunc;
+			pInterceptWriteTable[addr-0xff8000] = pInterceptAccessFuncs[i].WriteFunc;
+		}
+	}
+#else
 	for (addr=0xff8000; addr <= 0xffffff; addr++)
 	{
 		/* Does this hardware location/span appear in our list of possible intercepted functions? */
@@ -318,6 +342,7 @@ void IoMem_Init(void)
 			}
 		}
 	}
+#endif
 
 	/* After the IO access handlers were set, some machines with common IoMemTable_xxx */
 	/* will require some extra changes (eg: ST vs MegaST, STE ve MegaSTE) */
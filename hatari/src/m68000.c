@@ -779,6 +779,10 @@ void	M68000_SyncCpuBus_OnWriteAccess ( void )
 void	M68000_Flush_All_Caches ( uaecptr addr , int size )
 {
 //fprintf ( stderr , "M68000_Flush_All_Caches\n" );
+#ifdef __LIBRETRO__
+	/* Atari memory is about to be modified directly, mark it for incremental savestates */
+	STMemory_MarkDirtyRange ( addr , size );
+#endif
 	flush_cpu_caches(true);
 	invalidate_cpu_data_caches();
 }
@@ -795,6 +799,9 @@ void	M68000_Flush_Instr_Cache ( uaecptr addr , int size )
 void	M68000_Flush_Data_Cache ( uaecptr addr , int size )
 {
 //fprintf ( stderr , "M68000_Flush_Data_Cache\n" );
+#ifdef __LIBRETRO__
+	STMemory_MarkDirtyRange ( addr , size );
+#endif
 	/* Data cache for cpu >= 68030 */
 	invalidate_cpu_data_caches();
 }
@@ -183,7 +183,7 @@ static int MemorySnapShot_fseek(MSS_File fhndl, int pos)
 #ifdef COMPRESS_MEMORYSNAPSHOT
 	return (int)gzseek(fhndl, pos, SEEK_CUR);	/* return -1 if error, new position >=0 if OK */
 #elif defined(__LIBRETRO__)
-	core_snapshot_seek(pos);
+	core_snapshot_skip(pos);
 	(void)fhndl;
 	return 0;
 #else
@@ -510,7 +510,13 @@ void MemorySnapShot_Restore_Do(void)
 
 		/* Reset emulator to get things running */
 		IoMem_UnInit();  IoMem_Init();
+#ifndef __LIBRETRO__
+		Reset_Cold();
+#else
+		STMemory_SkipClear = true;
 		Reset_Cold();
+		STMemory_SkipClear = false;
+#endif
 
 		/* Capture each files details */
 	LIBRETRO_DEBUG_SNAPSHOT("STMemory");
@@ -69,6 +69,9 @@ static int Reset_ST(bool bCold)
 			return ret;               /* If we can not load a TOS image, return now! */
 
 		Cart_ResetImage();          /* Load cartridge program into ROM memory. */
+#ifdef __LIBRETRO__
+		STMemory_RomLoaded();       /* ROM contents are now known, for savestates */
+#endif
 
 		/* Video timings can change only on cold boot (wakeup states) */
 		Video_SetTimings ( ConfigureParams.System.nMachineType , ConfigureParams.System.VideoTimingMode );
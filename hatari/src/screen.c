@@ -222,7 +222,11 @@ static void Screen_ConvertHighRes(void)
 	int linewidth = 640 / 16;
 
 	Screen_GenConvert(VideoBase, pSTScreen, 640, 400, 1, linewidth, 0, 0, 0, 0, 0);
+#ifdef __LIBRETRO__
+	bScreenContentsChanged = ScreenConv_Changed();
+#else
 	bScreenContentsChanged = true;
+#endif
 }
 
 /**
@@ -230,6 +234,18 @@ static void Screen_ConvertHighRes(void)
  */
 static void Screen_SetDrawFunctions(int nBitCount, bool bDoubleLowRes)
 {
+#ifdef __LIBRETRO__
+	Convert_SimdInit();
+	if (nBitCount <= 16)
+	{
+		if (bDoubleLowRes)
+			ScreenDrawFunctionsNormal[ST_LOW_RES] = ConvertLowRes_640x16Bit;
+		else
+			ScreenDrawFunctionsNormal[ST_LOW_RES] = ConvertLowRes_320x16Bit;
+		ScreenDrawFunctionsNormal[ST_MEDIUM_RES] = ConvertMediumRes_640x16Bit;
+		return;
+	}
+#endif
 	if (bDoubleLowRes)
 		ScreenDrawFunctionsNormal[ST_LOW_RES] = ConvertLowRes_640x32Bit;
 	else
@@ -706,10 +722,10 @@ static bool Screen_SetSDLVideoSize(int width, int height, bool bForceChange)
 		// no renderer, no window, just a SWSURFACE buffer
 		int am, bitdepth;
 
-		// in Hatari 2.5.0 bitdepth is no longer supported, always 32
-		//switch (core_pixel_format)
-		//{
-		//default:
+		// Hatari 2.5.0 only has 32-bit converters,
+		// hatariB adds 16-bit ones for RGB565 (0RGB1555 is unsupported)
+		switch (core_pixel_format)
+		{
 		//case 0: // 0RGB1555
 		//	bitdepth = 16;
 		//	rm = 0x7C00;
@@ -717,21 +733,22 @@ static bool Screen_SetSDLVideoSize(int width, int height, bool bForceChange)
 		//	bm = 0x001F;
 		//	am = 0x8000;
 		//	break;
-		//case 1: // XRGB8888
+		default:
+		case 1: // XRGB8888
 			bitdepth = 32;
 			rm = 0x00FF0000;
 			gm = 0x0000FF00;
 			bm = 0x000000FF;
 			am = 0xFF000000;
-		//	break;
-		//case 2: // RGB565
-		//	bitdepth = 16;
-		//	rm = 0xF800;
-		//	gm = 0x07E0;
-		//	bm = 0x001F;
-		//	am = 0x0000;
-		//	break;
-		//}
+			break;
+		case 2: // RGB565
+			bitdepth = 16;
+			rm = 0xF800;
+			gm = 0x07E0;
+			bm = 0x001F;
+			am = 0x0000;
+			break;
+		}
 		sdlscrn = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, bitdepth,
 		                               rm, gm, bm, am);
 		// make sure core has valid pointer to screen data (even if not yet initialized)
@@ -1077,8 +1094,29 @@ void Screen_SetFullUpdate(void)
 {
 	/* Update frame buffers */
 	FrameBuffer.bFullUpdate = true;
+#ifdef __LIBRETRO__
+	ScreenConv_SetFullUpdate();
+#endif
 }
 
+#ifdef __LIBRETRO__
+/**
+ * Called by the core before each frame: a frame the frontend won't show
+ * (run-ahead, netplay replay) is emulated without drawing it.
+ * The skipped frames leave the change tracking behind, so redraw everything when shown again.
+ */
+extern void core_screen_enable(bool enable);
+void core_screen_enable(bool enable)
+{
+	static bool bWasEnabled = true;
+
+	if (enable && !bWasEnabled)
+		Screen_SetFullUpdate();
+	bWasEnabled = enable;
+	ConfigureParams.Screen.DisableVideo = !enable;
+}
+#endif
+
 
 /*-----------------------------------------------------------------------*/
 /**
@@ -1090,6 +1128,7 @@ static void Screen_ClearScreen(void)
 	SDL_FillRect(sdlscrn, &STScreenRect, SDL_MapRGB(sdlscrn->format, 0, 0, 0));
 #else
 	SDL_FillRect(sdlscrn, &STScreenRect, STRGBPalette[0]); // use palette 0 because it looks better while emulation is paused
+	ScreenConv_SetFullUpdate(); // the generic converter keeps unchanged lines
 #endif
 }
 
@@ -1546,6 +1585,14 @@ static bool Screen_DrawFrame(bool bForceFlip)
 			pDrawFunction = ConvertLowRes_640x32Bit_Spec;
 		else if (pDrawFunction==ConvertMediumRes_640x32Bit)
 			pDrawFunction = ConvertMediumRes_640x32Bit_Spec;
+#ifdef __LIBRETRO__
+		else if (pDrawFunction==ConvertLowRes_320x16Bit)
+			pDrawFunction = ConvertLowRes_320x16Bit_Spec;
+		else if (pDrawFunction==ConvertLowRes_640x16Bit)
+			pDrawFunction = ConvertLowRes_640x16Bit_Spec;
+		else if (pDrawFunction==ConvertMediumRes_640x16Bit)
+			pDrawFunction = ConvertMediumRes_640x16Bit_Spec;
+#endif
 	}
 	else if (bPrevFrameWasSpec512)
 	{
@@ -1746,6 +1793,12 @@ void Screen_GenConvUpdate(SDL_Rect *extra, bool forced)
 	if ( ConfigureParams.Screen.DisableVideo )
 		return;
 
+#ifdef __LIBRETRO__
+	/* nothing new to show, the core can report a duplicate frame */
+	if (!forced && !extra && !ScreenConv_Changed())
+		return;
+#endif
+
 	rects[0] = STScreenRect;
 	if (extra) {
 		rects[1] = *extra;
@@ -1867,9 +1920,47 @@ static Uint32* Double_ScreenLine32(Uint32 *line, int size)
 	return next;
 }
 
+#ifdef __LIBRETRO__
+/**
+ * 16-bit version of Double_ScreenLine32 for the RGB565 pixel format
+ */
+static Uint16* Double_ScreenLine16(Uint16 *line, int size)
+{
+	SDL_PixelFormat *fmt;
+	int fmt_size = size/2;
+	Uint16 *next;
+	Uint16 mask;
+
+	if (!bLibretroDoubleYEnable)
+		return line + fmt_size;
+
+	next = line + fmt_size;
+	/* copy as-is */
+	if (bScrDoubleY)
+	{
+		memcpy(next, line, size);
+		return next + fmt_size;
+	}
+	/* TV-mode -- halve the intensity while copying */
+	fmt = sdlscrn->format;
+	mask = ((fmt->Rmask >> 1) & fmt->Rmask)
+	     | ((fmt->Gmask >> 1) & fmt->Gmask)
+	     | ((fmt->Bmask >> 1) & fmt->Bmask);
+	do {
+		*next++ = (*line++ >> 1) & mask;
+	}
+	while (--fmt_size);
+
+	return next;
+}
+#endif
+
 
 /* lookup tables and conversion macros */
 #include "convert/macros.h"
+#ifdef __LIBRETRO__
+#include "convert/simd.h"
+#endif
 
 /* Conversion routines */
 
@@ -1879,3 +1970,11 @@ static Uint32* Double_ScreenLine32(Uint32 *line, int size)
 #include "convert/low320x32_spec.c"	/* LowRes Spectrum 512 To 320xH x 32-bit color */
 #include "convert/low640x32_spec.c"	/* LowRes Spectrum 512 To 640xH x 32-bit color */
 #include "convert/med640x32_spec.c"	/* MediumRes Spectrum 512 To 640xH x 32-bit color */
+#ifdef __LIBRETRO__
+#include "convert/low320x16.c"		/* LowRes To 320xH x 16-bit color */
+#include "convert/low640x16.c"		/* LowRes To 640xH x 16-bit color */
+#include "convert/med640x16.c"		/* MediumRes To 640xH x 16-bit color */
+#include "convert/low320x16_spec.c"	/* LowRes Spectrum 512 To 320xH x 16-bit color */
+#include "convert/low640x16_spec.c"	/* LowRes Spectrum 512 To 640xH x 16-bit color */
+#include "convert/med640x16_spec.c"	/* MediumRes Spectrum 512 To 640xH x 16-bit color */
+#endif
@@ -50,7 +50,16 @@ void Screen_SetPaletteColor(Uint8 idx, Uint8 red, Uint8 green, Uint8 blue)
 	palette.standard[idx].g = green;
 	palette.standard[idx].b = blue;
 	// convert the color to native
+#ifndef __LIBRETRO__
 	palette.native[idx] = SDL_MapRGB(sdlscrn->format, red, green, blue);
+#else
+	Uint32 native = SDL_MapRGB(sdlscrn->format, red, green, blue);
+	if (palette.native[idx] != native)
+	{
+		palette.native[idx] = native;
+		ScreenConv_SetFullUpdate(); // unchanged lines would keep the old colour
+	}
+#endif
 }
 
 SDL_Color Screen_GetPaletteColor(Uint8 idx)
@@ -68,6 +77,9 @@ void Screen_RemapPalette(void)
 	for(i = 0; i < 256; i++, native++, standard++) {
 		*native = SDL_MapRGB(fmt, standard->r, standard->g, standard->b);
 	}
+#ifdef __LIBRETRO__
+	ScreenConv_SetFullUpdate();
+#endif
 }
 
 void ScreenConv_MemorySnapShot_Capture(bool bSave)
@@ -84,6 +96,15 @@ static void Screen_memset_uint32(Uint32 *addr, Uint32 color, int count)
 	}
 }
 
+#ifdef __LIBRETRO__
+static void Screen_memset_uint16(Uint16 *addr, Uint16 color, int count)
+{
+	while (count-- > 0) {
+		*addr++ = color;
+	}
+}
+#endif
+
 static inline Uint32 idx2pal(Uint8 idx)
 {
 	if (unlikely(bTTSampleHold))
@@ -95,6 +116,363 @@ static inline Uint32 idx2pal(Uint8 idx)
 	return palette.native[idx];
 }
 
+#ifdef __LIBRETRO__
+/*
+ * SIMD conversion (hatariB)
+ *
+ * Bitplanes: the planes of a 16-pixel block are transposed in one vector,
+ * giving each pixel's palette index without any per-bit shifting.
+ * HiColor: 8 pixels at a time are expanded from RGB565 to the host format,
+ * which must be 32-bit with 8 bits per colour at the usual shifts.
+ *
+ * x86 uses SSE2 when the CPU has it, ARM uses NEON when built for it,
+ * otherwise the original scalar code is used.
+ * DEBUG_SCREENCONV_SIMD 1 compares every SIMD line against the scalar
+ * conversion and logs any mismatch.
+ */
+#define DEBUG_SCREENCONV_SIMD   0
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+# if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define SCREENCONV_SIMD_SSE2 1
+#  include <emmintrin.h>
+#  define SCREENCONV_SIMD_TARGET __attribute__((target("sse2")))
+# elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define SCREENCONV_SIMD_NEON 1
+#  include <arm_neon.h>
+#  define SCREENCONV_SIMD_TARGET
+# endif
+#endif
+
+static int nScreenConvSimd = -1;        /* -1 until the CPU has been checked */
+static bool bScreenConvSimdHiColor;     /* host format suits the HiColor conversion */
+static Uint32 nScreenConvAmask;         /* alpha bits that SDL_MapRGB would add */
+
+static bool ScreenConv_SimdBitplanes(int vbpp)
+{
+	if (nScreenConvSimd < 0)
+	{
+		nScreenConvSimd = 0;
+#if defined(SCREENCONV_SIMD_SSE2)
+		__builtin_cpu_init();
+		nScreenConvSimd = __builtin_cpu_supports("sse2") ? 1 : 0;
+#elif defined(SCREENCONV_SIMD_NEON)
+		nScreenConvSimd = 1;
+#endif
+	}
+	return nScreenConvSimd && !bTTSampleHold &&
+		(vbpp == 1 || vbpp == 2 || vbpp == 4 || vbpp == 8);
+}
+
+static void ScreenConv_SimdCheckFormat(void)
+{
+	const SDL_PixelFormat *fmt = sdlscrn->format;
+
+	bScreenConvSimdHiColor = nScreenConvSimd > 0 && fmt->BytesPerPixel == 4 &&
+		fmt->Rmask == 0x00ff0000 && fmt->Gmask == 0x0000ff00 && fmt->Bmask == 0x000000ff;
+	nScreenConvAmask = fmt->Amask;
+}
+
+#if defined(SCREENCONV_SIMD_SSE2)
+
+/* Convert 'count' 16-pixel blocks of 'vbpp' (1, 2, 4 or 8) bitplanes */
+static void SCREENCONV_SIMD_TARGET ScreenConv_SimdBitplaneBlocks(const Uint16 *fvram, Uint32 *hvram,
+                                                                 int count, int vbpp)
+{
+	const Uint32 *native = palette.native;
+	const __m128i lowbytes = _mm_set1_epi16(0x00ff);
+	int i;
+
+	while (count-- > 0)
+	{
+		__m128i v;
+		Uint32 w;
+
+		if (vbpp == 8)
+			v = _mm_loadu_si128((const __m128i *)fvram);
+		else if (vbpp == 4)
+			v = _mm_loadl_epi64((const __m128i *)fvram);
+		else if (vbpp == 2)
+		{
+			memcpy(&w, fvram, sizeof(w));
+			v = _mm_cvtsi32_si128(w);
+		}
+		else
+			v = _mm_cvtsi32_si128(fvram[0]);
+
+		/* Plane words are big endian: gather the high bytes (pixels 0-7)
+		 * of all planes, then the low bytes (pixels 8-15), so that
+		 * byte p of each half belongs to plane p */
+		v = _mm_packus_epi16(_mm_and_si128(v, lowbytes), _mm_srli_epi16(v, 8));
+
+		/* The top bit of every byte is now the plane bit of pixel i and i+8,
+		 * movemask collects them into the palette indices */
+		for (i = 0; i < 8; i++)
+		{
+			int m = _mm_movemask_epi8(v);
+			hvram[i] = native[m & 0xff];
+			hvram[i+8] = native[m >> 8];
+			v = _mm_add_epi8(v, v);
+		}
+
+		fvram += vbpp;
+		hvram += 16;
+	}
+}
+
+/* Convert 'count' big endian RGB565 pixels */
+static void SCREENCONV_SIMD_TARGET ScreenConv_SimdHiColorLine(const Uint16 *fvram, Uint32 *hvram, int count)
+{
+	const __m128i amask = _mm_set1_epi32(nScreenConvAmask);
+	const __m128i m3 = _mm_set1_epi16(0x0003);
+	const __m128i m7 = _mm_set1_epi16(0x0007);
+	const __m128i mf8 = _mm_set1_epi16(0x00f8);
+	const __m128i mfc = _mm_set1_epi16(0x00fc);
+
+	for (; count >= 8; count -= 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)fvram);
+		__m128i r, g, b, gb;
+
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 8), mf8), _mm_srli_epi16(v, 13));
+		g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 3), mfc), _mm_and_si128(_mm_srli_epi16(v, 9), m3));
+		b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 3), mf8), _mm_and_si128(_mm_srli_epi16(v, 2), m7));
+		gb = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+		_mm_storeu_si128((__m128i *)(hvram+0), _mm_or_si128(_mm_unpacklo_epi16(gb, r), amask));
+		_mm_storeu_si128((__m128i *)(hvram+4), _mm_or_si128(_mm_unpackhi_epi16(gb, r), amask));
+		fvram += 8;
+		hvram += 8;
+	}
+	for (; count > 0; count--)
+	{
+		Uint16 srcword = SDL_SwapBE16(*fvram++);
+		Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
+		*hvram++ = (r << 16) | (g << 8) | b | nScreenConvAmask;
+	}
+}
+
+#elif defined(SCREENCONV_SIMD_NEON)
+
+/* Convert 'count' 16-pixel blocks of 'vbpp' (1, 2, 4 or 8) bitplanes */
+static void ScreenConv_SimdBitplaneBlocks(const Uint16 *fvram, Uint32 *hvram,
+                                          int count, int vbpp)
+{
+	static const Uint8 bitlist[16] = { 128,64,32,16,8,4,2,1,128,64,32,16,8,4,2,1 };
+	const uint8x16_t bits = vld1q_u8(bitlist);
+	const Uint32 *native = palette.native;
+	Uint8 idx[16];
+	int i, p;
+
+	while (count-- > 0)
+	{
+		const Uint8 *src = (const Uint8 *)fvram;
+		uint8x16_t v = vdupq_n_u8(0);
+
+		/* high byte of each big endian plane word is the left 8 pixels */
+		for (p = 0; p < vbpp; p++)
+		{
+			uint8x16_t plane = vcombine_u8(vdup_n_u8(src[2*p]), vdup_n_u8(src[2*p+1]));
+			v = vorrq_u8(v, vandq_u8(vtstq_u8(plane, bits), vdupq_n_u8(1 << p)));
+		}
+		vst1q_u8(idx, v);
+		for (i = 0; i < 16; i++)
+			hvram[i] = native[idx[i]];
+
+		fvram += vbpp;
+		hvram += 16;
+	}
+}
+
+/* Convert 'count' big endian RGB565 pixels */
+static void ScreenConv_SimdHiColorLine(const Uint16 *fvram, Uint32 *hvram, int count)
+{
+	const uint32x4_t amask = vdupq_n_u32(nScreenConvAmask);
+	const uint16x8_t m3 = vdupq_n_u16(0x0003);
+	const uint16x8_t m7 = vdupq_n_u16(0x0007);
+	const uint16x8_t mf8 = vdupq_n_u16(0x00f8);
+	const uint16x8_t mfc = vdupq_n_u16(0x00fc);
+
+	for (; count >= 8; count -= 8)
+	{
+		uint16x8_t v = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8((const Uint8 *)fvram)));
+		uint16x8_t r = vorrq_u16(vandq_u16(vshrq_n_u16(v, 8), mf8), vshrq_n_u16(v, 13));
+		uint16x8_t g = vorrq_u16(vandq_u16(vshrq_n_u16(v, 3), mfc), vandq_u16(vshrq_n_u16(v, 9), m3));
+		uint16x8_t b = vorrq_u16(vandq_u16(vshlq_n_u16(v, 3), mf8), vandq_u16(vshrq_n_u16(v, 2), m7));
+		uint16x8x2_t px = vzipq_u16(vorrq_u16(vshlq_n_u16(g, 8), b), r);
+		vst1q_u32(hvram+0, vorrq_u32(vreinterpretq_u32_u16(px.val[0]), amask));
+		vst1q_u32(hvram+4, vorrq_u32(vreinterpretq_u32_u16(px.val[1]), amask));
+		fvram += 8;
+		hvram += 8;
+	}
+	for (; count > 0; count--)
+	{
+		Uint16 srcword = SDL_SwapBE16(*fvram++);
+		Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
+		*hvram++ = (r << 16) | (g << 8) | b | nScreenConvAmask;
+	}
+}
+
+#else
+
+/* no SIMD available, nScreenConvSimd is never set */
+static void ScreenConv_SimdBitplaneBlocks(const Uint16 *fvram, Uint32 *hvram, int count, int vbpp) {}
+static void ScreenConv_SimdHiColorLine(const Uint16 *fvram, Uint32 *hvram, int count) {}
+
+#endif
+
+#endif /* __LIBRETRO__ */
+
+#ifdef __LIBRETRO__
+/*
+ * Unchanged line skipping (hatariB)
+ *
+ * Like the ST converters do with pSTScreenCopy, a copy of each source line
+ * is kept, and lines that are the same as in the previous frame keep their
+ * previous output. A change of palette, geometry or host surface,
+ * or a full update, converts every line again.
+ */
+typedef struct
+{
+	Uint8 *hvram;
+	int pitch, scrwidth, scrheight;
+	int vw, vh, vbpp, nextline, hscroll;
+	int leftBorder, rightBorder, upperBorder, lowerBorder;
+	int coefx, coefy;
+	bool bSampleHold;
+} SCREENCONV_CACHEKEY;
+
+static struct
+{
+	SCREENCONV_CACHEKEY key;
+	Uint8 *lines;       /* source lines as they were last converted */
+	bool *valid;        /* line copy matches what is on the host surface */
+	int nLines;         /* lines in use */
+	int nLineBytes;     /* source bytes read for each line */
+	size_t nAlloc;      /* size of lines */
+	bool bFullUpdate;
+} screen_cache = { .bFullUpdate = true };
+
+static bool bScreenConvChanged;        /* last conversion changed the host surface */
+
+void ScreenConv_SetFullUpdate(void)
+{
+	screen_cache.bFullUpdate = true;
+}
+
+/**
+ * Returns true if the last Screen_GenConvert changed anything on the host surface
+ */
+bool ScreenConv_Changed(void)
+{
+	return bScreenConvChanged;
+}
+
+/**
+ * Prepare the line cache for a frame, invalidating it if anything other
+ * than the source lines could change the output.
+ */
+static void ScreenConv_CacheBegin(Uint8 *hvram, int scrwidth, int scrheight,
+                                  int vw, int vh, int vbpp, int nextline, int hscroll,
+                                  int leftBorder, int rightBorder,
+                                  int upperBorder, int lowerBorder,
+                                  int coefx, int coefy)
+{
+	SCREENCONV_CACHEKEY key;
+	size_t size;
+
+	memset(&key, 0, sizeof(key)); /* clear padding for memcmp */
+	key.hvram = hvram;
+	key.pitch = sdlscrn->pitch;
+	key.scrwidth = scrwidth;
+	key.scrheight = scrheight;
+	key.vw = vw;
+	key.vh = vh;
+	key.vbpp = vbpp;
+	key.nextline = nextline;
+	key.hscroll = hscroll;
+	key.leftBorder = leftBorder;
+	key.rightBorder = rightBorder;
+	key.upperBorder = upperBorder;
+	key.lowerBorder = lowerBorder;
+	key.coefx = coefx;
+	key.coefy = coefy;
+	key.bSampleHold = bTTSampleHold;
+
+	if (!screen_cache.bFullUpdate && screen_cache.lines &&
+	    !memcmp(&key, &screen_cache.key, sizeof(key)))
+		return;
+
+	screen_cache.key = key;
+	screen_cache.bFullUpdate = false;
+	bScreenConvChanged = true;
+	/* zoomed lines are indexed through zoomytable, which includes the borders */
+	screen_cache.nLines = vh + upperBorder + lowerBorder;
+	if (vbpp < 16)
+		screen_cache.nLineBytes = (((vw + 15) >> 4) + (hscroll ? 1 : 0)) * vbpp * 2;
+	else
+		screen_cache.nLineBytes = vw * 2;
+
+	size = (size_t)screen_cache.nLines * screen_cache.nLineBytes;
+	if (size > screen_cache.nAlloc)
+	{
+		free(screen_cache.lines);
+		free(screen_cache.valid);
+		screen_cache.lines = malloc(size);
+		screen_cache.valid = malloc(sizeof(bool) * screen_cache.nLines);
+		screen_cache.nAlloc = size;
+		if (!screen_cache.lines || !screen_cache.valid)
+		{
+			free(screen_cache.lines);
+			free(screen_cache.valid);
+			screen_cache.lines = NULL;
+			screen_cache.valid = NULL;
+			screen_cache.nAlloc = 0;
+			return;
+		}
+	}
+	memset(screen_cache.valid, 0, sizeof(bool) * screen_cache.nLines);
+}
+
+/**
+ * Returns true if source line y is the same as when it was last converted,
+ * otherwise remembers it for the next frame.
+ */
+static bool ScreenConv_LineUnchanged(int y, const Uint16 *fvram_line)
+{
+	Uint8 *copy;
+
+	if (screen_cache.lines && y < screen_cache.nLines)
+	{
+		copy = screen_cache.lines + (size_t)y * screen_cache.nLineBytes;
+		if (screen_cache.valid[y] && !memcmp(copy, fvram_line, screen_cache.nLineBytes))
+			return true;
+
+		memcpy(copy, fvram_line, screen_cache.nLineBytes);
+		screen_cache.valid[y] = true;
+	}
+	bScreenConvChanged = true;
+	return false;
+}
+
+/* Source line y was not converted this frame */
+static void ScreenConv_LineInvalid(int y)
+{
+	if (screen_cache.lines && y < screen_cache.nLines)
+	{
+		if (screen_cache.valid[y])
+			bScreenConvChanged = true;
+		screen_cache.valid[y] = false;
+	}
+	else
+		bScreenConvChanged = true;
+}
+#endif /* __LIBRETRO__ */
+
 
 /**
  * Performs conversion from the TOS's bitplane word order (big endian) data
@@ -197,6 +575,54 @@ static inline Uint32 *ScreenConv_BitplaneLineTo32bpp(Uint16 *fvram_column,
 	Uint32 hvram_buf[16];
 	int i;
 
+#ifdef __LIBRETRO__
+	if (ScreenConv_SimdBitplanes(vbpp))
+	{
+		int blocks = (vw + 15) >> 4;
+#if DEBUG_SCREENCONV_SIMD
+		Uint32 *hvram_start = hvram_column;
+		Uint16 *fvram_start = fvram_column;
+#endif
+
+		/* First 16 pixels */
+		ScreenConv_SimdBitplaneBlocks(fvram_column, hvram_buf, 1, vbpp);
+		for (i = hscrolloffset; i < 16; i++)
+			*hvram_column++ = hvram_buf[i];
+		fvram_column += vbpp;
+
+		/* Now the main part of the line */
+		if (blocks > 1)
+		{
+			ScreenConv_SimdBitplaneBlocks(fvram_column, hvram_column, blocks - 1, vbpp);
+			hvram_column += 16 * (blocks - 1);
+			fvram_column += vbpp * (blocks - 1);
+		}
+
+		/* Last pixels of the line for fine scrolling */
+		if (hscrolloffset)
+		{
+			ScreenConv_SimdBitplaneBlocks(fvram_column, hvram_buf, 1, vbpp);
+			for (i = 0; i < hscrolloffset; i++)
+				*hvram_column++ = hvram_buf[i];
+		}
+
+#if DEBUG_SCREENCONV_SIMD
+		{
+			int n = hvram_column - hvram_start;
+			Uint32 *check = malloc(sizeof(Uint32) * (n + 16));
+			nScreenConvSimd = 0;
+			ScreenConv_BitplaneLineTo32bpp(fvram_start, check, vw, vbpp, hscrolloffset);
+			nScreenConvSimd = 1;
+			if (memcmp(check, hvram_start, sizeof(Uint32) * n))
+				Log_Printf(LOG_ERROR, "ScreenConv SIMD bitplane mismatch: %d bpp, %d wide, scroll %d\n",
+				           vbpp, vw, hscrolloffset);
+			free(check);
+		}
+#endif
+		return hvram_column;
+	}
+#endif
+
 	/* First 16 pixels */
 	Screen_BitplaneToChunky32(fvram_column, vbpp, hvram_buf);
 	for (i = hscrolloffset; i < 16; i++)
@@ -253,11 +679,24 @@ static void ScreenConv_BitplaneTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 
 		if (nLineEndAddr > STRamEnd)
 		{
+#ifdef __LIBRETRO__
+			ScreenConv_LineInvalid(h);
+#endif
 			Screen_memset_uint32(hvram_line, palette.native[0], pitch);
 			hvram_line += pitch;
 			continue;
 		}
 
+#ifdef __LIBRETRO__
+		if (ScreenConv_LineUnchanged(h, fvram_line))
+		{
+			nLineEndAddr += nextline * 2;
+			fvram_line += nextline;
+			hvram_line += pitch;
+			continue;
+		}
+#endif
+
 		nSampleHoldIdx = 0;
 
 		/* Left border first */
@@ -310,16 +749,51 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 
 		if (nLineEndAddr > STRamEnd)
 		{
+#ifdef __LIBRETRO__
+			ScreenConv_LineInvalid(h);
+#endif
 			Screen_memset_uint32(hvram_line, palette.native[0], pitch);
 			hvram_line += pitch;
 			continue;
 		}
 
+#ifdef __LIBRETRO__
+		if (ScreenConv_LineUnchanged(h, fvram_line))
+		{
+			nLineEndAddr += nextline * 2;
+			fvram_line += nextline;
+			hvram_line += pitch;
+			continue;
+		}
+#endif
+
 		/* Left border first */
 		Screen_memset_uint32(hvram_column, palette.native[0], leftBorder);
 		hvram_column += leftBorder;
 
 		/* Graphical area */
+#ifdef __LIBRETRO__
+		if (bScreenConvSimdHiColor)
+		{
+			ScreenConv_SimdHiColorLine(fvram_column, hvram_column, vw);
+#if DEBUG_SCREENCONV_SIMD
+			for (w = 0; w < vw; w++)
+			{
+				Uint16 srcword = SDL_SwapBE16(fvram_column[w]);
+				Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+				Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+				Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
+				if (hvram_column[w] != SDL_MapRGB(sdlscrn->format, r, g, b))
+				{
+					Log_Printf(LOG_ERROR, "ScreenConv SIMD HiColor mismatch: %d wide, at %d\n", vw, w);
+					break;
+				}
+			}
+#endif
+			hvram_column += vw;
+		}
+		else
+#endif
 		for (w = 0; w < vw; w++)
 		{
 			Uint16 srcword = SDL_SwapBE16(*fvram_column++);
@@ -345,6 +819,184 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 	}
 }
 
+#ifdef __LIBRETRO__
+/*
+ * 16-bit host formats (hatariB RGB565 output)
+ *
+ * palette.native already holds 16-bit values, so bitplane lines use the
+ * 32-bit line conversion (and its SIMD path) into a line buffer, then
+ * narrow it. Falcon HiColor is RGB565 already, so for an RGB565 host
+ * it is only byte swapped.
+ */
+static void ScreenConv_HiColorLineTo16bpp(const Uint16 *fvram_column, Uint16 *hvram_column,
+                                          const int *zoomxtable, int count)
+{
+	SDL_PixelFormat *fmt = sdlscrn->format;
+	int w;
+
+	if (fmt->Rmask == 0xF800 && fmt->Gmask == 0x07E0 && fmt->Bmask == 0x001F && !fmt->Amask)
+	{
+		if (zoomxtable)
+		{
+			for (w = 0; w < count; w++)
+				hvram_column[w] = SDL_SwapBE16(fvram_column[zoomxtable[w]]);
+		}
+		else
+		{
+			for (w = 0; w < count; w++)
+				hvram_column[w] = SDL_SwapBE16(fvram_column[w]);
+		}
+		return;
+	}
+
+	for (w = 0; w < count; w++)
+	{
+		Uint16 srcword = SDL_SwapBE16(fvram_column[zoomxtable ? zoomxtable[w] : w]);
+		Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
+		hvram_column[w] = SDL_MapRGB(fmt, r, g, b);
+	}
+}
+
+static void ScreenConv_BitplaneTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
+                                             int scrwidth, int scrheight,
+                                             int vw, int vh, int vbpp,
+                                             int nextline, int hscrolloffset,
+                                             int leftBorder, int rightBorder,
+                                             int upperBorder, int lowBorder)
+{
+	/* One complete 16-pixel aligned planar 2 chunky line */
+	Uint32 *p2cline = malloc(sizeof(Uint32) * ((vw+15) & ~15));
+	Uint16 *hvram_line = (Uint16 *)hvram;
+	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	int pitch = sdlscrn->pitch >> 1;
+	int h;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	for (h = 0; h < vh; h++)
+	{
+		Uint16 *hvram_column = hvram_line;
+		Uint32 *p2cend;
+		Uint32 *p2c;
+
+		if (nLineEndAddr > STRamEnd)
+		{
+			ScreenConv_LineInvalid(h);
+			Screen_memset_uint16(hvram_line, palette.native[0], pitch);
+			hvram_line += pitch;
+			continue;
+		}
+
+		if (ScreenConv_LineUnchanged(h, fvram_line))
+		{
+			nLineEndAddr += nextline * 2;
+			fvram_line += nextline;
+			hvram_line += pitch;
+			continue;
+		}
+
+		nSampleHoldIdx = 0;
+
+		/* Left border first */
+		Screen_memset_uint16(hvram_column, palette.native[0], leftBorder);
+		hvram_column += leftBorder;
+
+		p2cend = ScreenConv_BitplaneLineTo32bpp(fvram_line, p2cline,
+		                                        vw, vbpp, hscrolloffset);
+		for (p2c = p2cline; p2c < p2cend; p2c++)
+			*hvram_column++ = *p2c;
+
+		/* Right border */
+		Screen_memset_uint16(hvram_column, palette.native[0], rightBorder);
+
+		nLineEndAddr += nextline * 2;
+		fvram_line += nextline;
+		hvram_line += pitch;
+	}
+
+	/* Render the lower border */
+	for (h = 0; h < lowBorder; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	free(p2cline);
+}
+
+static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
+                                            int scrwidth, int scrheight,
+                                            int vw, int vh, int vbpp,
+                                            int nextline, int hscrolloffset,
+                                            int leftBorder, int rightBorder,
+                                            int upperBorder, int lowBorder)
+{
+	Uint16 *hvram_line = (Uint16 *)hvram;
+	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	int pitch = sdlscrn->pitch >> 1;
+	int h;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	for (h = 0; h < vh; h++)
+	{
+		Uint16 *hvram_column = hvram_line;
+
+		if (nLineEndAddr > STRamEnd)
+		{
+			ScreenConv_LineInvalid(h);
+			Screen_memset_uint16(hvram_line, palette.native[0], pitch);
+			hvram_line += pitch;
+			continue;
+		}
+
+		if (ScreenConv_LineUnchanged(h, fvram_line))
+		{
+			nLineEndAddr += nextline * 2;
+			fvram_line += nextline;
+			hvram_line += pitch;
+			continue;
+		}
+
+		/* Left border first */
+		Screen_memset_uint16(hvram_column, palette.native[0], leftBorder);
+		hvram_column += leftBorder;
+
+		/* Graphical area */
+		ScreenConv_HiColorLineTo16bpp(fvram_line, hvram_column, NULL, vw);
+		hvram_column += vw;
+
+		/* Right border */
+		Screen_memset_uint16(hvram_column, palette.native[0], rightBorder);
+
+		nLineEndAddr += nextline * 2;
+		fvram_line += nextline;
+		hvram_line += pitch;
+	}
+
+	/* Render the bottom border */
+	for (h = 0; h < lowBorder; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+}
+#endif
+
 static void Screen_ConvertWithoutZoom(Uint16 *fvram, int vw, int vh, int vbpp, int nextline,
                                       int hscrolloffset, int leftBorder, int rightBorder,
                                       int upperBorder, int lowerBorder)
@@ -411,7 +1063,29 @@ static void Screen_ConvertWithoutZoom(Uint16 *fvram, int vw, int vh, int vbpp, i
 
 	scrwidth = leftBorder + vw + rightBorder;
 
+#ifdef __LIBRETRO__
+	ScreenConv_CacheBegin(hvram, scrwidth, scrheight, vw, vh, vbpp,
+	                      nextline, hscrolloffset, leftBorder, rightBorderSize,
+	                      upperBorder, lowBorderSize, 1, 1);
+#endif
+
 	/* render the graphic area */
+#ifdef __LIBRETRO__
+	if (nBytesPerPixel == 2) {
+		if (vbpp < 16)
+			ScreenConv_BitplaneTo16bppNoZoom(fvram, hvram,
+			                                 scrwidth, scrheight, vw, vh,
+			                                 vbpp, nextline, hscrolloffset,
+			                                 leftBorder, rightBorderSize,
+			                                 upperBorder, lowBorderSize);
+		else
+			ScreenConv_HiColorTo16bppNoZoom(fvram, hvram,
+			                                scrwidth, scrheight, vw, vh,
+			                                vbpp, nextline, hscrolloffset,
+			                                leftBorder, rightBorderSize,
+			                                upperBorder, lowBorderSize);
+	} else
+#endif
 	if (vbpp < 16) {
 		/* Bitplanes modes */
 		ScreenConv_BitplaneTo32bppNoZoom(fvram, hvram,
@@ -449,6 +1123,9 @@ static void ScreenConv_BitplaneTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 	int cursrcline = -1;
 	int scrIdx = 0;
 	int w, h;
+#ifdef __LIBRETRO__
+	bool bSkipLine = false;
+#endif
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder * coefy; h++)
@@ -467,12 +1144,26 @@ static void ScreenConv_BitplaneTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 		/* Recopy the same line ? */
 		if (screen_zoom.zoomytable[h] == cursrcline)
 		{
+#ifdef __LIBRETRO__
+			if (!bSkipLine)
+#endif
 			memcpy(hvram_line, hvram_line - pitch, scrwidth * nBytesPerPixel);
 		}
 		else if (nLineEndAddr > STRamEnd)
 		{
+#ifdef __LIBRETRO__
+			ScreenConv_LineInvalid(screen_zoom.zoomytable[h]);
+			bSkipLine = false;
+#endif
 			Screen_memset_uint32(hvram_line, palette.native[0], pitch);
 		}
+#ifdef __LIBRETRO__
+		else if ((bSkipLine = ScreenConv_LineUnchanged(screen_zoom.zoomytable[h], fvram_line)))
+		{
+			/* keep this line and its zoomed copies from last frame */
+			nLineEndAddr += nextline * 2;
+		}
+#endif
 		else
 		{
 			ScreenConv_BitplaneLineTo32bpp(fvram_line, p2cline,
@@ -527,6 +1218,14 @@ static void ScreenConv_HiColorTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 	int cursrcline = -1;
 	int scrIdx = 0;
 	int w, h;
+#ifdef __LIBRETRO__
+	bool bSkipLine = false;
+#endif
+#ifdef __LIBRETRO__
+	/* One converted source line, to zoom from */
+	int hcline_len = (vw * coefx > 0) ? (screen_zoom.zoomxtable[vw * coefx - 1] + 1) : 0;
+	Uint32 *hcline = bScreenConvSimdHiColor ? malloc(sizeof(Uint32) * hcline_len) : NULL;
+#endif
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder * coefy; h++)
@@ -547,12 +1246,26 @@ static void ScreenConv_HiColorTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 		/* Recopy the same line ? */
 		if (screen_zoom.zoomytable[h] == cursrcline)
 		{
+#ifdef __LIBRETRO__
+			if (!bSkipLine)
+#endif
 			memcpy(hvram_line, hvram_line - pitch, scrwidth * nBytesPerPixel);
 		}
 		else if (nLineEndAddr > STRamEnd)
 		{
+#ifdef __LIBRETRO__
+			ScreenConv_LineInvalid(screen_zoom.zoomytable[h]);
+			bSkipLine = false;
+#endif
 			Screen_memset_uint32(hvram_line, palette.native[0], pitch);
 		}
+#ifdef __LIBRETRO__
+		else if ((bSkipLine = ScreenConv_LineUnchanged(screen_zoom.zoomytable[h], fvram_line)))
+		{
+			/* keep this line and its zoomed copies from last frame */
+			nLineEndAddr += nextline * 2;
+		}
+#endif
 		else
 		{
 			hvram_column = hvram_line;
@@ -562,6 +1275,15 @@ static void ScreenConv_HiColorTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 			hvram_column += leftBorder * coefx;
 
 			/* Display the Graphical area */
+#ifdef __LIBRETRO__
+			if (hcline)
+			{
+				ScreenConv_SimdHiColorLine(fvram_column, hcline, hcline_len);
+				for (w = 0; w < vw * coefx; w++)
+					*hvram_column ++ = hcline[screen_zoom.zoomxtable[w]];
+			}
+			else
+#endif
 			for (w = 0; w < vw * coefx; w++)
 			{
 				Uint16 srcword;
@@ -589,8 +1311,181 @@ static void ScreenConv_HiColorTo32bppZoomed(Uint16 *fvram, Uint8 *hvram,
 		Screen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
+
+#ifdef __LIBRETRO__
+	free(hcline);
+#endif
+}
+
+#ifdef __LIBRETRO__
+static void ScreenConv_BitplaneTo16bppZoomed(Uint16 *fvram, Uint8 *hvram,
+                                             int scrwidth, int scrheight,
+                                             int vw, int vh, int vbpp,
+                                             int nextline, int hscrolloffset,
+                                             int leftBorder, int rightBorder,
+                                             int upperBorder, int lowerBorder,
+                                             int coefx, int coefy)
+{
+	/* One complete 16-pixel aligned planar 2 chunky line */
+	Uint32 *p2cline = malloc(sizeof(Uint32) * ((vw+15) & ~15));
+	Uint16 *hvram_line = (Uint16 *)hvram;
+	Uint16 *hvram_column;
+	Uint16 *fvram_line;
+	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	int pitch = sdlscrn->pitch >> 1;
+	int cursrcline = -1;
+	int scrIdx = 0;
+	int w, h;
+	bool bSkipLine = false;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder * coefy; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	for (h = 0; h < scrheight; h++)
+	{
+		fvram_line = fvram + (screen_zoom.zoomytable[scrIdx] * nextline);
+		scrIdx ++;
+		nSampleHoldIdx = 0;
+
+		/* Recopy the same line ? */
+		if (screen_zoom.zoomytable[h] == cursrcline)
+		{
+			if (!bSkipLine)
+				memcpy(hvram_line, hvram_line - pitch, scrwidth * 2);
+		}
+		else if (nLineEndAddr > STRamEnd)
+		{
+			ScreenConv_LineInvalid(screen_zoom.zoomytable[h]);
+			bSkipLine = false;
+			Screen_memset_uint16(hvram_line, palette.native[0], pitch);
+		}
+		else if ((bSkipLine = ScreenConv_LineUnchanged(screen_zoom.zoomytable[h], fvram_line)))
+		{
+			/* keep this line and its zoomed copies from last frame */
+			nLineEndAddr += nextline * 2;
+		}
+		else
+		{
+			ScreenConv_BitplaneLineTo32bpp(fvram_line, p2cline,
+			                               vw, vbpp, hscrolloffset);
+
+			hvram_column = hvram_line;
+			/* Display the Left border */
+			Screen_memset_uint16(hvram_column, palette.native[0], leftBorder * coefx);
+			hvram_column += leftBorder * coefx;
+
+			/* Display the Graphical area */
+			for (w = 0; w < vw * coefx; w++)
+			{
+				hvram_column[w] = p2cline[screen_zoom.zoomxtable[w]];
+			}
+			hvram_column += vw * coefx;
+
+			/* Display the Right border */
+			Screen_memset_uint16(hvram_column, palette.native[0], rightBorder * coefx);
+
+			nLineEndAddr += nextline * 2;
+		}
+
+		hvram_line += pitch;
+		cursrcline = screen_zoom.zoomytable[h];
+	}
+
+	/* Render the lower border */
+	for (h = 0; h < lowerBorder * coefy; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	free(p2cline);
 }
 
+static void ScreenConv_HiColorTo16bppZoomed(Uint16 *fvram, Uint8 *hvram,
+                                            int scrwidth, int scrheight,
+                                            int vw, int vh, int vbpp,
+                                            int nextline, int hscrolloffset,
+                                            int leftBorder, int rightBorder,
+                                            int upperBorder, int lowerBorder,
+                                            int coefx, int coefy)
+{
+	Uint16 *hvram_line = (Uint16 *)hvram;
+	Uint16 *hvram_column;
+	Uint16 *fvram_line;
+	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	int pitch = sdlscrn->pitch >> 1;
+	int cursrcline = -1;
+	int scrIdx = 0;
+	int h;
+	bool bSkipLine = false;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder * coefy; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	for (h = 0; h < scrheight; h++)
+	{
+		fvram_line = fvram + (screen_zoom.zoomytable[scrIdx] * nextline);
+		scrIdx ++;
+
+		/* Recopy the same line ? */
+		if (screen_zoom.zoomytable[h] == cursrcline)
+		{
+			if (!bSkipLine)
+				memcpy(hvram_line, hvram_line - pitch, scrwidth * 2);
+		}
+		else if (nLineEndAddr > STRamEnd)
+		{
+			ScreenConv_LineInvalid(screen_zoom.zoomytable[h]);
+			bSkipLine = false;
+			Screen_memset_uint16(hvram_line, palette.native[0], pitch);
+		}
+		else if ((bSkipLine = ScreenConv_LineUnchanged(screen_zoom.zoomytable[h], fvram_line)))
+		{
+			/* keep this line and its zoomed copies from last frame */
+			nLineEndAddr += nextline * 2;
+		}
+		else
+		{
+			hvram_column = hvram_line;
+
+			/* Display the Left border */
+			Screen_memset_uint16(hvram_column, palette.native[0], leftBorder * coefx);
+			hvram_column += leftBorder * coefx;
+
+			/* Display the Graphical area */
+			ScreenConv_HiColorLineTo16bpp(fvram_line, hvram_column,
+			                              screen_zoom.zoomxtable, vw * coefx);
+			hvram_column += vw * coefx;
+
+			/* Display the Right border */
+			Screen_memset_uint16(hvram_column, palette.native[0], rightBorder * coefx);
+
+			nLineEndAddr += nextline * 2;
+		}
+
+		hvram_line += pitch;
+		cursrcline = screen_zoom.zoomytable[h];
+	}
+
+	/* Render the lower border */
+	for (h = 0; h < lowerBorder * coefy; h++)
+	{
+		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+}
+#endif
+
 static void Screen_ConvertWithZoom(Uint16 *fvram, int vw, int vh, int vbpp, int nextline,
                                    int hscrolloffset, int leftBorder, int rightBorder,
                                    int upperBorder, int lowerBorder)
@@ -670,6 +1565,26 @@ static void Screen_ConvertWithZoom(Uint16 *fvram, int vw, int vh, int vbpp, int
 		return;
 	}
 
+#ifdef __LIBRETRO__
+	ScreenConv_CacheBegin(hvram, scrwidth, scrheight, vw, vh, vbpp,
+	                      nextline, hscrolloffset, leftBorder, rightBorder,
+	                      upperBorder, lowerBorder, coefx, coefy);
+#endif
+
+#ifdef __LIBRETRO__
+	if (scrbpp == 2) {
+		if (vbpp < 16)
+			ScreenConv_BitplaneTo16bppZoomed(fvram, hvram, scrwidth, scrheight,
+			                                 vw, vh, vbpp, nextline, hscrolloffset,
+			                                 leftBorder, rightBorder, upperBorder,
+			                                 lowerBorder, coefx, coefy);
+		else
+			ScreenConv_HiColorTo16bppZoomed(fvram, hvram, scrwidth, scrheight,
+			                                vw, vh, vbpp, nextline, hscrolloffset,
+			                                leftBorder, rightBorder, upperBorder,
+			                                lowerBorder, coefx, coefy);
+	} else
+#endif
 	if (vbpp<16) {
 		/* Bitplanes modes */
 		ScreenConv_BitplaneTo32bppZoomed(fvram, hvram, scrwidth, scrheight,
@@ -695,6 +1610,9 @@ void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
 	ConvertH = vh;
 	ConvertBPP = vbpp;
 	ConvertNextLine = nextline * 2;	/* bytes per line */
+#ifdef __LIBRETRO__
+	bScreenConvChanged = false;
+#endif
 
 	/* Override drawing palette for screenshots */
 	ConvertPalette = palette.native;
@@ -702,6 +1620,11 @@ void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
 	if (ConvertPaletteSize > 256)
 		ConvertPaletteSize = 256;
 
+#ifdef __LIBRETRO__
+	ScreenConv_SimdBitplanes(vbpp); /* checks the CPU on first use */
+	ScreenConv_SimdCheckFormat();
+#endif
+
 	if (nScreenZoomX * nScreenZoomY != 1) {
 		Screen_ConvertWithZoom(fvram, vw, vh, vbpp, nextline, hscroll,
 		                       leftBorderSize, rightBorderSize,
@@ -719,6 +1642,11 @@ bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
 {
 	int hscrolloffset;
 
+#ifdef __LIBRETRO__
+	/* unchanged lines are not redrawn, so the overlay led must be removed */
+	Statusbar_OverlayRestore(sdlscrn);
+#endif
+
 	if (ConfigureParams.Screen.DisableVideo || !Screen_Lock())
 		return false;
 
@@ -731,6 +1659,9 @@ bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
 	                  leftBorder, rightBorder, upperBorder, lowerBorder);
 
 	Screen_UnLock();
+#ifdef __LIBRETRO__
+	Statusbar_OverlayBackup(sdlscrn);
+#endif
 	Screen_GenConvUpdate(Statusbar_Update(sdlscrn, false), false);
 	return true;
 }
@@ -149,6 +149,15 @@ const char Sound_fileid[] = "Hatari sound.c";
 #include "avi_record.h"
 #include "clocks_timings.h"
 
+#ifdef __LIBRETRO__
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+extern bool core_audio_enable; // false while the frontend discards audio (run-ahead, netplay replay)
+extern bool core_audio_filter; // false if tone filters can be skipped (audio disabled, or fast-forward)
+#endif
 
 
 /*--------------------------------------------------------------*/
@@ -184,6 +193,11 @@ static const int YmEnvDef[ 16 ][ 3 ] = {
 /* Buffer to store the 16 envelopes built from YmEnvDef */
 static ymu16	YmEnvWaves[ 16 ][ 32 * 3 ];		/* 16 envelopes with 3 blocks of 32 volumes */
 
+#ifdef __LIBRETRO__
+/* Noise generator state after 8 steps, for the 8 low bits of the state (see YM2149_RndBuild) */
+static ymu32	YmRnd8[ 256 ];
+#endif
+
 
 
 /*--------------------------------------------------------------*/
@@ -256,6 +270,11 @@ static yms16 *ymout5 = (yms16 *)ymout5_u16;
 /* Uncomment next line to write raw 250 kHz samples to a file 'hatari_250.wav' */
 //#define YM_250_DEBUG
 
+#ifdef __LIBRETRO__
+/* Uncomment next line to check every YM2149_DoSamples_250_Span against YM2149_DoSamples_250 */
+//#define YM_250_SPAN_DEBUG
+#endif
+
 
 /* For our internal computations to convert down/up square wave signals into 0-31 volume, */
 /* we consider that 'up' is 31 and 'down' is 0 */
@@ -298,6 +317,27 @@ static double	pos_fract_nearest;			/* For YM2149_Next_Resample_Nearest */
 static double	pos_fract_weighted_2;			/* For YM2149_Next_Resample_Weighted_Average_2 */
 static uint32_t	pos_fract_weighted_n;			/* YM2149_Next_Resample_Weighted_Average_N */
 
+#ifdef __LIBRETRO__
+#define		YM_FIR_PHASES_BITS	8
+#define		YM_FIR_PHASES		( 1 << YM_FIR_PHASES_BITS )
+#define		YM_FIR_TAPS		24		/* Length of a band-limited step, in output samples (multiple of 8) */
+#define		YM_FIR_ACC_SIZE		1024		/* Ring of pending changes to the output (must be a power of 2) */
+#define		YM_FIR_EDGES_CHUNK	256		/* Samples of YM_Buffer_250 checked for edges before adding their steps */
+
+static yms16	YM_FIR_Table[ YM_FIR_PHASES ][ YM_FIR_TAPS ];	/* Band-limited impulse for each fractional position of an edge */
+static yms32	YM_FIR_Acc[ YM_FIR_ACC_SIZE + YM_FIR_TAPS ];	/* Changes to add to the next output samples, see YM2149_FIR_Output */
+static uint8_t	YM_FIR_Edge_Pos[ 256 ][ 8 ];		/* Positions of the bits set in a byte (1 to 8), see YM2149_FIR_Edges */
+static uint8_t	YM_FIR_Edge_Count[ 256 ];		/* Number of bits set in a byte */
+static int	YM_FIR_Acc_Pos;
+static yms32	YM_FIR_Sum;				/* Current output level, times 0x4000 */
+static int	YM_FIR_End = -1;			/* Last position in YM_Buffer_250 checked for edges, -1 to start again */
+static int	YM_FIR_Freq = 0;			/* YM_REPLAY_FREQ and YM_ATARI_CLOCK_COUNTER for YM_FIR_Interval */
+static uint32_t	YM_FIR_Clock = 0;
+static uint32_t	YM_FIR_Interval;			/* Same as interval_fract in YM2149_Next_Resample_Weighted_Average_N */
+static uint64_t	YM_FIR_Interval_Inv;			/* 2^48 / YM_FIR_Interval */
+static int	YM_FIR_Scan_Max;			/* Edges further ahead of the current output sample don't fit in YM_FIR_Acc yet */
+#endif
+
 
 bool		bEnvelopeFreqFlag;			/* Cleared each frame for YM saving */
 
@@ -360,13 +400,25 @@ static void	Ym2149_Init		(void);
 static void	Ym2149_Reset		(void);
 
 static ymu32	YM2149_RndCompute	(void);
+#ifdef __LIBRETRO__
+static void	YM2149_RndBuild		(void);
+static void	YM2149_FIR_Build	(void);
+#endif
 static ymu16	YM2149_TonePer		(ymu8 rHigh , ymu8 rLow);
 static ymu16	YM2149_NoisePer		(ymu8 rNoise);
 static ymu16	YM2149_EnvPer		(ymu8 rHigh , ymu8 rLow);
 
 static void	YM2149_Run		( uint64_t CPU_Clock );
 static int	Sound_GenerateSamples	( uint64_t CPU_Clock);
+#if !defined(__LIBRETRO__) || defined(YM_250_SPAN_DEBUG)
 static void	YM2149_DoSamples_250	( int SamplesToGenerate_250 );
+#endif
+#ifdef __LIBRETRO__
+static void	YM2149_DoSamples_250_Span ( int SamplesToGenerate_250 );
+#endif
+#ifdef YM_250_SPAN_DEBUG
+static void	YM2149_DoSamples_250_SpanCheck ( int SamplesToGenerate_250 );
+#endif
 #ifdef YM_250_DEBUG
 static void	YM2149_DoSamples_250_Debug ( int SamplesToGenerate , int pos );
 #endif
@@ -388,6 +440,10 @@ ymsample	Subsonic_IIR_HPF_Left(ymsample x0)
 
 	if ( YM2149_HPF_Filter == YM2149_HPF_FILTER_NONE )
 		return x0;
+#ifdef __LIBRETRO__
+	if ( !core_audio_enable )	/* kept in fast-forward, toggling it would pop */
+		return x0;
+#endif
 
 	y1 += ((x0 - x1)<<15) - (y0<<6);  /*  64*y0  */
 	y0 = y1>>15;
@@ -403,6 +459,10 @@ ymsample	Subsonic_IIR_HPF_Right(ymsample x0)
 
 	if ( YM2149_HPF_Filter == YM2149_HPF_FILTER_NONE )
 		return x0;
+#ifdef __LIBRETRO__
+	if ( !core_audio_enable )	/* kept in fast-forward, toggling it would pop */
+		return x0;
+#endif
 
 	y1 += ((x0 - x1)<<15) - (y0<<6);  /*  64*y0  */
 	y0 = y1>>15;
@@ -927,6 +987,14 @@ static void	Ym2149_Init(void)
 	/* Build the 16 envelope shapes */
 	YM2149_EnvBuild();
 
+#ifdef __LIBRETRO__
+	/* Build the table to advance the noise generator by 8 steps */
+	YM2149_RndBuild();
+
+	/* Build the band-limited steps for YM2149_Next_Resample_FIR */
+	YM2149_FIR_Build();
+#endif
+
 	/* Build the volume conversion table */
 	Ym2149_BuildVolumeTable();
 
@@ -941,6 +1009,9 @@ static void	Ym2149_Init(void)
 	memset ( YM_Buffer_250 , 0 , sizeof(YM_Buffer_250) );
 	YM_Buffer_250_pos_write = 0;
 	YM_Buffer_250_pos_read = 0;
+#ifdef __LIBRETRO__
+	YM_FIR_End = -1;
+#endif
 }
 
 
@@ -997,6 +1068,28 @@ static ymu32	YM2149_RndCompute(void)
 }
 
 
+#ifdef __LIBRETRO__
+/**
+ * The LFSR is linear, and the feedback bits take more than 8 steps to reach bit 0,
+ * so 8 steps can be done at once with : RndRack = ( RndRack >> 8 ) ^ YmRnd8[ RndRack & 0xff ]
+ */
+static void	YM2149_RndBuild(void)
+{
+	ymu32	Save = RndRack;
+	int	i , j;
+
+	for ( i = 0 ; i < 256 ; i++ )
+	{
+		RndRack = i;
+		for ( j = 0 ; j < 8 ; j++ )
+			YM2149_RndCompute();
+		YmRnd8[ i ] = RndRack;
+	}
+	RndRack = Save;
+}
+#endif
+
+
 
 static ymu16	YM2149_TonePer(ymu8 rHigh , ymu8 rLow)
 {
@@ -1037,6 +1130,7 @@ static ymu16	YM2149_EnvPer(ymu8 rHigh , ymu8 rLow)
  * Creating a complete 250 kHz signal allow to emulate effects that require
  * precise cycle accuracy (such as "syncsquare" used in maxYMiser v1.53)
  */
+#if !defined(__LIBRETRO__) || defined(YM_250_SPAN_DEBUG)
 static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 {
 	ymsample	sample;
@@ -1154,6 +1248,277 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 
 //fprintf ( stderr , "ym2149_dosamples_250 out nb=%d ym_pos_wr=%d\n",SamplesToGenerate_250 , YM_Buffer_250_pos_write );
 }
+#endif
+
+
+#ifdef __LIBRETRO__
+/*-----------------------------------------------------------------------*/
+/**
+ * Span based version of YM2149_DoSamples_250, giving the same output and state.
+ * The output only changes when a tone, noise or envelope counter reaches its period,
+ * so instead of emulating each 250 kHz cycle we jump directly to the next such event
+ * and fill the samples in between with the same value.
+ * Counters that can't be heard with the current mixer and volume settings don't end
+ * a span, they are advanced in closed form with the others.
+ */
+
+/* Ticks until a counter reaches its period (as in YM2149_DoSamples_250, per==0 acts as per==1) */
+static inline int	YM2149_Span_Ticks ( ymu16 count , ymu16 per )
+{
+	int	ticks = (int)per - (int)count;
+
+	return ( ticks < 1 ) ? 1 : ticks;
+}
+
+/* Advance a counter by 'ticks' increments, return how many times it reached its period */
+static inline int	YM2149_Span_Advance ( ymu16 *count , ymu16 per , int ticks )
+{
+	int	first = YM2149_Span_Ticks ( *count , per );
+	int	period = per ? per : 1;
+
+	if ( ticks < first )
+	{
+		*count += ticks;
+		return 0;
+	}
+	*count = ( ticks - first ) % period;
+	return 1 + ( ticks - first ) / period;
+}
+
+/* Current output sample, built from the values of tone/noise/volume/env */
+static inline ymsample	YM2149_Span_Output ( void )
+{
+	ymu32		bt;
+	ymu16		Env3Voices;			/* 0x00CCBBAA */
+	ymu16		Tone3Voices;			/* 0x00CCBBAA */
+
+	Env3Voices = YmEnvWaves[ Env_shape ][ Env_pos ];
+	Env3Voices &= EnvMask3Voices;
+
+	bt = (ToneA_val | mixerTA) & (Noise_val | mixerNA);
+	Tone3Voices = bt & YM_MASK_1VOICE;
+	bt = (ToneB_val | mixerTB) & (Noise_val | mixerNB);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 5;
+	bt = (ToneC_val | mixerTC) & (Noise_val | mixerNC);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 10;
+
+	Tone3Voices &= ( Env3Voices | Vol3Voices );
+	return ymout5[ Tone3Voices ];
+}
+
+/* Emulate 'ticks' internal YM2149 cycles during which no audible counter reaches its period */
+static inline void	YM2149_Span_Skip ( int ticks )
+{
+	int	n;
+
+	if ( YM2149_Span_Advance ( &ToneA_count , ToneA_per , ticks ) & 1 )
+		ToneA_val ^= YM_SQUARE_UP;
+	if ( YM2149_Span_Advance ( &ToneB_count , ToneB_per , ticks ) & 1 )
+		ToneB_val ^= YM_SQUARE_UP;
+	if ( YM2149_Span_Advance ( &ToneC_count , ToneC_per , ticks ) & 1 )
+		ToneC_val ^= YM_SQUARE_UP;
+
+	/* Noise counter is increased at 125 KHz, on every tick where YM2149_Freq_div_2 goes back to 0. */
+	/* With a period of 0 it reaches it on every tick, otherwise the caller ensures Noise_count < Noise_per */
+	/* so it can only happen after an increment. */
+	if ( Noise_per == 0 )
+	{
+		n = ticks;
+		Noise_count = 0;
+	}
+	else
+		n = YM2149_Span_Advance ( &Noise_count , Noise_per , YM2149_Freq_div_2 ? ( ticks + 1 ) / 2 : ticks / 2 );
+	YM2149_Freq_div_2 ^= ticks & 1;
+	if ( n > 0 )
+	{
+		/* Only the last step's result is needed for Noise_val */
+		for ( ; n > 8 ; n -= 8 )
+			RndRack = ( RndRack >> 8 ) ^ YmRnd8[ RndRack & 0xff ];
+		while ( --n > 0 )
+			YM2149_RndCompute();
+		Noise_val = YM2149_RndCompute();
+	}
+
+	Env_pos += YM2149_Span_Advance ( &Env_count , Env_per , ticks );
+	if ( Env_pos >= 3*32 )				/* replay/loop blocks 1 and 2 (Env_pos 32 to 95) */
+		Env_pos = 32 + ( Env_pos - 32 ) % ( 2*32 );
+}
+
+/* Emulate 1 internal YM2149 cycle, exactly as in YM2149_DoSamples_250 */
+static inline ymsample	YM2149_Span_Tick ( void )
+{
+	YM2149_Freq_div_2 ^= 1;
+	if ( YM2149_Freq_div_2 == 0 )
+		Noise_count++;
+	if ( Noise_count >= Noise_per )
+	{
+		Noise_count = 0;
+		Noise_val = YM2149_RndCompute();
+	}
+
+	ToneA_count++;
+	if ( ToneA_count >= ToneA_per )
+	{
+		ToneA_count = 0;
+		ToneA_val ^= YM_SQUARE_UP;
+	}
+
+	ToneB_count++;
+	if ( ToneB_count >= ToneB_per )
+	{
+		ToneB_count = 0;
+		ToneB_val ^= YM_SQUARE_UP;
+	}
+
+	ToneC_count++;
+	if ( ToneC_count >= ToneC_per )
+	{
+		ToneC_count = 0;
+		ToneC_val ^= YM_SQUARE_UP;
+	}
+
+	Env_count += 1;
+	if ( Env_count >= Env_per )
+	{
+		Env_count = 0;
+		Env_pos += 1;
+		if ( Env_pos >= 3*32 )
+			Env_pos -= 2*32;
+	}
+
+	return YM2149_Span_Output ();
+}
+
+static void	YM2149_DoSamples_250_Span ( int SamplesToGenerate_250 )
+{
+	ymu16		Audible3Voices = EnvMask3Voices | Vol3Voices;
+	bool		bToneA , bToneB , bToneC , bNoise , bEnv;
+	ymsample	sample;
+	int		pos;
+	int		n , span , len;
+
+	/* Registers can't change during this call, so which counters can be heard is fixed */
+	bToneA = !mixerTA && ( Audible3Voices & YM_MASK_A );
+	bToneB = !mixerTB && ( Audible3Voices & YM_MASK_B );
+	bToneC = !mixerTC && ( Audible3Voices & YM_MASK_C );
+	bNoise = ( !mixerNA && ( Audible3Voices & YM_MASK_A ) )
+	      || ( !mixerNB && ( Audible3Voices & YM_MASK_B ) )
+	      || ( !mixerNC && ( Audible3Voices & YM_MASK_C ) );
+	bEnv = ( EnvMask3Voices != 0 );
+
+	pos = YM_Buffer_250_pos_write;
+	sample = YM2149_Span_Output ();
+
+	n = SamplesToGenerate_250;
+	while ( n > 0 )
+	{
+		/* Number of ticks until the output can change */
+		span = n + 1;
+		if ( bToneA && YM2149_Span_Ticks ( ToneA_count , ToneA_per ) < span )
+			span = YM2149_Span_Ticks ( ToneA_count , ToneA_per );
+		if ( bToneB && YM2149_Span_Ticks ( ToneB_count , ToneB_per ) < span )
+			span = YM2149_Span_Ticks ( ToneB_count , ToneB_per );
+		if ( bToneC && YM2149_Span_Ticks ( ToneC_count , ToneC_per ) < span )
+			span = YM2149_Span_Ticks ( ToneC_count , ToneC_per );
+		if ( bEnv && YM2149_Span_Ticks ( Env_count , Env_per ) < span )
+			span = YM2149_Span_Ticks ( Env_count , Env_per );
+		if ( Noise_per == 0 )
+		{
+			if ( bNoise )
+				span = 1;
+		}
+		else if ( Noise_count >= Noise_per )
+			span = 1;
+		else if ( bNoise )
+		{
+			len = 2 * ( Noise_per - Noise_count ) - YM2149_Freq_div_2;
+			if ( len < span )
+				span = len;
+		}
+
+		/* Fill the unchanged samples before it */
+		len = ( span - 1 < n ) ? span - 1 : n;
+		if ( len > 0 )
+		{
+			YM2149_Span_Skip ( len );
+			n -= len;
+			while ( len > 0 )
+			{
+				int	run = YM_BUFFER_250_SIZE - pos;
+				int	i;
+
+				if ( run > len )
+					run = len;
+				for ( i = 0 ; i < run ; i++ )
+					YM_Buffer_250[ pos + i ] = sample;
+				pos = ( pos + run ) & YM_BUFFER_250_SIZE_MASK;
+				len -= run;
+			}
+		}
+
+		/* And emulate the tick where it changes */
+		if ( n > 0 )
+		{
+			sample = YM2149_Span_Tick ();
+			YM_Buffer_250[ pos ] = sample;
+			pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+			n--;
+		}
+	}
+
+#ifdef YM_250_DEBUG
+	YM2149_DoSamples_250_Debug ( SamplesToGenerate_250 , YM_Buffer_250_pos_write );
+#endif
+
+	YM_Buffer_250_pos_write = pos;
+}
+#endif
+
+
+#ifdef YM_250_SPAN_DEBUG
+/*-----------------------------------------------------------------------*/
+/**
+ * Run both YM2149_DoSamples_250 and YM2149_DoSamples_250_Span from the same state,
+ * and report any difference in their output or final state.
+ */
+static void	YM2149_DoSamples_250_SpanCheck ( int SamplesToGenerate_250 )
+{
+	static ymsample	Ref_Buffer[ YM_BUFFER_250_SIZE ];
+	ymu16	Start16[ 10 ] , Ref16[ 10 ];
+	ymu32	Start32[ 2 ] , Ref32[ 2 ];
+	ymu16	*Vars16[ 10 ] = { &ToneA_count , &ToneA_val , &ToneB_count , &ToneB_val , &ToneC_count , &ToneC_val ,
+				  &Noise_count , &Noise_val , &Env_count , &YM2149_Freq_div_2 };
+	ymu32	*Vars32[ 2 ] = { &Env_pos , &RndRack };
+	int	pos = YM_Buffer_250_pos_write;
+	int	i;
+
+	for ( i = 0 ; i < 10 ; i++ )	Start16[ i ] = *Vars16[ i ];
+	for ( i = 0 ; i < 2 ; i++ )	Start32[ i ] = *Vars32[ i ];
+
+	YM2149_DoSamples_250 ( SamplesToGenerate_250 );
+	for ( i = 0 ; i < SamplesToGenerate_250 ; i++ )
+		Ref_Buffer[ i ] = YM_Buffer_250[ ( pos + i ) & YM_BUFFER_250_SIZE_MASK ];
+	for ( i = 0 ; i < 10 ; i++ )	{ Ref16[ i ] = *Vars16[ i ]; *Vars16[ i ] = Start16[ i ]; }
+	for ( i = 0 ; i < 2 ; i++ )	{ Ref32[ i ] = *Vars32[ i ]; *Vars32[ i ] = Start32[ i ]; }
+	YM_Buffer_250_pos_write = pos;
+
+	YM2149_DoSamples_250_Span ( SamplesToGenerate_250 );
+	for ( i = 0 ; i < SamplesToGenerate_250 ; i++ )
+	{
+		if ( Ref_Buffer[ i ] != YM_Buffer_250[ ( pos + i ) & YM_BUFFER_250_SIZE_MASK ] )
+		{
+			Log_Printf ( LOG_ERROR , "YM2149 span mismatch: sample %d of %d\n" , i , SamplesToGenerate_250 );
+			break;
+		}
+	}
+	for ( i = 0 ; i < 10 ; i++ )
+		if ( Ref16[ i ] != *Vars16[ i ] )
+			Log_Printf ( LOG_ERROR , "YM2149 span mismatch: state %d\n" , i );
+	for ( i = 0 ; i < 2 ; i++ )
+		if ( Ref32[ i ] != *Vars32[ i ] )
+			Log_Printf ( LOG_ERROR , "YM2149 span mismatch: state %d\n" , 10 + i );
+}
+#endif
 
 
 #ifdef YM_250_DEBUG
@@ -1274,7 +1639,13 @@ static void	YM2149_Run ( uint64_t CPU_Clock )
 
 	if ( YM2149_Nb_Updates_250 > 0 )
 	{
+#ifndef __LIBRETRO__
 		YM2149_DoSamples_250 ( YM2149_Nb_Updates_250 );
+#elif defined(YM_250_SPAN_DEBUG)
+		YM2149_DoSamples_250_SpanCheck ( YM2149_Nb_Updates_250 );
+#else
+		YM2149_DoSamples_250_Span ( YM2149_Nb_Updates_250 );
+#endif
 	}
 }
 
@@ -1407,6 +1778,320 @@ static ymsample	YM2149_Next_Resample_Weighted_Average_2 ( void )
 
 
 
+#ifdef __LIBRETRO__
+/*-----------------------------------------------------------------------*/
+/**
+ * Modified Bessel function of the first kind, for the Kaiser window
+ */
+static double	YM2149_FIR_BesselI0 ( double x )
+{
+	double	sum = 1.0 , term = 1.0;
+	int	k;
+
+	for ( k = 1 ; k < 32 ; k++ )
+	{
+		term *= ( x / ( 2 * k ) ) * ( x / ( 2 * k ) );
+		sum += term;
+	}
+	return sum;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Build the band-limited impulses for YM2149_Next_Resample_FIR.
+ *
+ * This is a Kaiser windowed sinc with its cutoff at half the output
+ * frequency, passing up to 42% of it and attenuating by 60 dB from 58%.
+ * Frequencies between 50% and 58% are not fully removed, but they can
+ * only alias above the passband.
+ * As it is in units of output samples, the same table is used for any
+ * YM_REPLAY_FREQ. Each phase is the impulse delayed by a fraction of an
+ * output sample, rounded so that it adds up to exactly 0x4000.
+ */
+static void	YM2149_FIR_Build ( void )
+{
+	const double	beta = 5.65;
+	const double	half = YM_FIR_TAPS / 2.0;
+	double		coef[ YM_FIR_TAPS ];
+	double		x , w , sum;
+	int		total , p , k;
+
+
+	for ( p = 0 ; p < YM_FIR_PHASES ; p++ )
+	{
+		sum = 0;
+		for ( k = 0 ; k < YM_FIR_TAPS ; k++ )
+		{
+			/* time from the centre of the impulse, which is half the taps after the edge */
+			x = k + ( p + 0.5 ) / YM_FIR_PHASES - half;
+			w = x / half;
+			w = ( fabs ( w ) < 1.0 ) ? YM2149_FIR_BesselI0 ( beta * sqrt ( 1.0 - w * w ) ) : 0.0;
+			coef[ k ] = w * ( ( x == 0.0 ) ? 1.0 : sin ( M_PI * x ) / ( M_PI * x ) );
+			sum += coef[ k ];
+		}
+
+		total = 0;
+		for ( k = 0 ; k < YM_FIR_TAPS ; k++ )
+		{
+			w = coef[ k ] * 0x4000 / sum;
+			YM_FIR_Table[ p ][ k ] = (yms16)( w < 0 ? w - 0.5 : w + 0.5 );
+			total += YM_FIR_Table[ p ][ k ];
+		}
+		YM_FIR_Table[ p ][ YM_FIR_TAPS / 2 ] += 0x4000 - total;
+	}
+
+	for ( p = 0 ; p < 256 ; p++ )
+	{
+		total = 0;
+		for ( k = 0 ; k < 8 ; k++ )
+			if ( p & ( 1 << k ) )
+				YM_FIR_Edge_Pos[ p ][ total++ ] = k + 1;
+		YM_FIR_Edge_Count[ p ] = total;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Add a band-limited step of 'delta' to the output samples from 'slot' on,
+ * 'slot' output samples after the current one.
+ * 'phase' is how long before that output sample the edge happened,
+ * in 1/YM_FIR_PHASES of an output sample.
+ * YM_OUTPUT_LEVEL keeps delta within 16 bits.
+ */
+static inline void	YM2149_FIR_AddStep ( int delta , uint32_t phase , int slot )
+{
+	const yms16	*h = YM_FIR_Table[ phase ];
+	yms32		*acc = YM_FIR_Acc + ( ( YM_FIR_Acc_Pos + slot ) & ( YM_FIR_ACC_SIZE - 1 ) );
+	int		k;
+
+#if defined(__SSE2__)
+	const __m128i	d = _mm_set1_epi16 ( delta );
+
+	for ( k = 0 ; k < YM_FIR_TAPS ; k += 8 )
+	{
+		__m128i	hv = _mm_loadu_si128 ( (const __m128i *)( h + k ) );
+		__m128i	lo = _mm_mullo_epi16 ( hv , d );
+		__m128i	hi = _mm_mulhi_epi16 ( hv , d );
+		_mm_storeu_si128 ( (__m128i *)( acc + k ) ,
+			_mm_add_epi32 ( _mm_loadu_si128 ( (const __m128i *)( acc + k ) ) , _mm_unpacklo_epi16 ( lo , hi ) ) );
+		_mm_storeu_si128 ( (__m128i *)( acc + k + 4 ) ,
+			_mm_add_epi32 ( _mm_loadu_si128 ( (const __m128i *)( acc + k + 4 ) ) , _mm_unpackhi_epi16 ( lo , hi ) ) );
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for ( k = 0 ; k < YM_FIR_TAPS ; k += 8 )
+	{
+		int16x8_t	hv = vld1q_s16 ( h + k );
+		vst1q_s32 ( acc + k , vmlal_n_s16 ( vld1q_s32 ( acc + k ) , vget_low_s16 ( hv ) , delta ) );
+		vst1q_s32 ( acc + k + 4 , vmlal_n_s16 ( vld1q_s32 ( acc + k + 4 ) , vget_high_s16 ( hv ) , delta ) );
+	}
+#else
+	for ( k = 0 ; k < YM_FIR_TAPS ; k++ )
+		acc[ k ] += delta * h[ k ];
+#endif
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Add the step for the edge at 'pos' in YM_Buffer_250 (a change from the
+ * previous sample), to the first output sample whose read position reaches it.
+ * The current output sample is at 'ref' + 'fract' / 0x10000, and each
+ * following one is exactly YM_FIR_Interval further.
+ */
+static inline void	YM2149_FIR_AddEdge ( int pos , int ref , uint32_t fract )
+{
+	int		dist = ( ( pos - ref + YM_BUFFER_250_SIZE / 2 ) & YM_BUFFER_250_SIZE_MASK ) - YM_BUFFER_250_SIZE / 2;
+	int64_t		ahead = (int64_t)dist * 0x10000 - fract;	/* from the current output sample to the edge */
+	uint64_t	q;
+	uint32_t	phase;
+	int		slot;
+
+	if ( ahead > 0 )
+	{
+		/* ahead / YM_FIR_Interval in 16.48 fixed point : the edge is reached by the output
+		 * sample after the integer part, and the fraction tells how long before it */
+		q = ahead * YM_FIR_Interval_Inv;
+		slot = ( q >> 48 ) + 1;
+		phase = ( ~q >> ( 48 - YM_FIR_PHASES_BITS ) ) & ( YM_FIR_PHASES - 1 );
+	}
+	else
+	{
+		slot = 0;
+		phase = ( -ahead * YM_FIR_Interval_Inv ) >> ( 48 - YM_FIR_PHASES_BITS );
+	}
+	YM2149_FIR_AddStep ( YM_Buffer_250[ pos ] - YM_Buffer_250[ ( pos - 1 ) & YM_BUFFER_250_SIZE_MASK ] , phase , slot );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Add the steps for all the edges after YM_FIR_End that have already been
+ * generated, up to as far ahead as YM_FIR_Acc can hold.
+ * The output sample at YM_FIR_Acc_Pos is at 'ref' + 'fract' / 0x10000.
+ * Checking the whole generated span at once is much cheaper than a few
+ * samples at each output sample. The positions of the edges are listed
+ * first without any branch, as they come at irregular intervals.
+ */
+static void	YM2149_FIR_Edges ( int ref , uint32_t fract )
+{
+	uint16_t	edges[ YM_FIR_EDGES_CHUNK + 8 ];
+	int		pos = YM_FIR_End;
+	int		count = ( YM_Buffer_250_pos_write - 1 - pos ) & YM_BUFFER_250_SIZE_MASK;
+	int		lead = ( ( ref - pos + YM_BUFFER_250_SIZE / 2 ) & YM_BUFFER_250_SIZE_MASK ) - YM_BUFFER_250_SIZE / 2;
+	int		chunk , n , i;
+
+	/* YM_FIR_End is usually ahead of 'ref', except when starting */
+	if ( count > lead + YM_FIR_Scan_Max )
+		count = lead + YM_FIR_Scan_Max;
+
+	while ( count > 0 )
+	{
+		chunk = ( count < YM_FIR_EDGES_CHUNK ) ? count : YM_FIR_EDGES_CHUNK;
+		count -= chunk;
+		n = 0;
+		while ( chunk > 0 )
+		{
+#if defined(__SSE2__)
+			/* Compare the next 8 samples with the previous ones at once */
+			if ( chunk >= 8 && pos + 9 <= YM_BUFFER_250_SIZE )
+			{
+				const __m128i	eq = _mm_cmpeq_epi16 ( _mm_loadu_si128 ( (const __m128i *)( YM_Buffer_250 + pos ) ) ,
+							_mm_loadu_si128 ( (const __m128i *)( YM_Buffer_250 + pos + 1 ) ) );
+				int		changed = ~_mm_movemask_epi8 ( _mm_packs_epi16 ( eq , eq ) ) & 0xff;
+
+				_mm_storeu_si128 ( (__m128i *)( edges + n ) , _mm_add_epi16 ( _mm_set1_epi16 ( pos ) ,
+					_mm_unpacklo_epi8 ( _mm_loadl_epi64 ( (const __m128i *)YM_FIR_Edge_Pos[ changed ] ) , _mm_setzero_si128 () ) ) );
+				n += YM_FIR_Edge_Count[ changed ];
+				pos += 8;
+				chunk -= 8;
+				continue;
+			}
+#endif
+			pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+			chunk--;
+			edges[ n ] = pos;
+			n += YM_Buffer_250[ pos ] != YM_Buffer_250[ ( pos - 1 ) & YM_BUFFER_250_SIZE_MASK ];
+		}
+		for ( i = 0 ; i < n ; i++ )
+			YM2149_FIR_AddEdge ( edges[ i ] , ref , fract );
+	}
+	YM_FIR_End = pos;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Move to the next output sample and return its level, times 0x4000.
+ * Steps that go past the end of YM_FIR_Acc are moved back to its start
+ * when the position wraps.
+ */
+static inline yms32	YM2149_FIR_Output ( void )
+{
+	int	i = YM_FIR_Acc_Pos;
+
+	YM_FIR_Sum += YM_FIR_Acc[ i ];
+	YM_FIR_Acc[ i ] = 0;
+	if ( ++i == YM_FIR_ACC_SIZE )
+	{
+		for ( i = 0 ; i < YM_FIR_TAPS ; i++ )
+		{
+			YM_FIR_Acc[ i ] += YM_FIR_Acc[ YM_FIR_ACC_SIZE + i ];
+			YM_FIR_Acc[ YM_FIR_ACC_SIZE + i ] = 0;
+		}
+		i = 0;
+	}
+	YM_FIR_Acc_Pos = i;
+	return YM_FIR_Sum;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start YM2149_Next_Resample_FIR from the current position, by going back
+ * YM_FIR_TAPS output samples, where all earlier steps were complete,
+ * and adding the steps since then. YM_Buffer_250 is kept in memory
+ * snapshots, so this gives the same output as if it had never stopped.
+ */
+static void	YM2149_FIR_Start ( void )
+{
+	uint32_t	dist , back;
+	int		m;
+
+
+	memset ( YM_FIR_Acc , 0 , sizeof ( YM_FIR_Acc ) );
+	YM_FIR_Acc_Pos = 0;
+
+	/* Position of the output sample YM_FIR_TAPS samples ago */
+	dist = YM_FIR_TAPS * YM_FIR_Interval - pos_fract_weighted_n;
+	back = ( dist + 0xffff ) >> 16;
+	YM_FIR_End = ( YM_Buffer_250_pos_read - back ) & YM_BUFFER_250_SIZE_MASK;
+	YM_FIR_Sum = YM_Buffer_250[ YM_FIR_End ] * 0x4000;
+
+	/* The steps of the output samples since then, up to the current one */
+	dist -= YM_FIR_Interval;
+	back = ( dist + 0xffff ) >> 16;
+	YM2149_FIR_Edges ( ( YM_Buffer_250_pos_read - back ) & YM_BUFFER_250_SIZE_MASK , ( back << 16 ) - dist );
+	for ( m = YM_FIR_TAPS - 1 ; m > 0 ; m-- )
+		YM2149_FIR_Output ();
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Downsample the YM2149 samples data from 250 KHz to YM_REPLAY_FREQ and
+ * return the next sample to output, with a polyphase FIR lowpass filter
+ * that replaces both the resampling method and the LPF filter.
+ *
+ * The YM2149 output only changes at a few edges, so instead of filtering
+ * every 250 kHz sample, each edge adds a band-limited step to the next
+ * YM_FIR_TAPS output samples (see YM2149_FIR_Build), and the output
+ * is the sum of all these changes.
+ * The read position advances exactly as in 'Weighted_Average_N'.
+ * This removes the aliasing of high notes and digi-drums, at the cost
+ * of a short delay (half the steps' length, about 0.25 ms).
+ */
+static ymsample	YM2149_Next_Resample_FIR ( void )
+{
+	yms32	sample;
+	int	behind;
+
+
+	if ( YM_FIR_Freq != YM_REPLAY_FREQ || YM_FIR_Clock != YM_ATARI_CLOCK_COUNTER )
+	{
+		YM_FIR_Freq = YM_REPLAY_FREQ;
+		YM_FIR_Clock = YM_ATARI_CLOCK_COUNTER;
+		YM_FIR_Interval = ( YM_ATARI_CLOCK_COUNTER * 0x10000LL ) / YM_REPLAY_FREQ;
+		YM_FIR_Interval_Inv = ( 1ULL << 48 ) / YM_FIR_Interval;
+		YM_FIR_Scan_Max = ( ( YM_FIR_ACC_SIZE - 2 * YM_FIR_TAPS ) * (uint64_t)YM_FIR_Interval ) >> 16;
+		YM_FIR_End = -1;
+	}
+
+	/* Same position as YM2149_Next_Resample_Weighted_Average_N, which moves to the next
+	 * sample first if pos_fract_weighted_n > 0, but YM_FIR_Interval is always more than 0x10000 */
+	pos_fract_weighted_n += YM_FIR_Interval;
+	YM_Buffer_250_pos_read = ( YM_Buffer_250_pos_read + ( pos_fract_weighted_n >> 16 ) ) & YM_BUFFER_250_SIZE_MASK;
+	pos_fract_weighted_n &= 0xffff;
+
+	/* Edges up to the read position must have been added already */
+	behind = ( YM_Buffer_250_pos_read - YM_FIR_End ) & YM_BUFFER_250_SIZE_MASK;
+	if ( YM_FIR_End < 0 || ( behind > 0 && behind < YM_BUFFER_250_SIZE / 2 ) )
+		YM2149_FIR_Start ();
+	if ( YM_FIR_End != ( ( YM_Buffer_250_pos_write - 1 ) & YM_BUFFER_250_SIZE_MASK ) )
+		YM2149_FIR_Edges ( YM_Buffer_250_pos_read , pos_fract_weighted_n );
+
+	sample = ( YM2149_FIR_Output () + 0x2000 ) >> 14;
+	if ( sample > 32767 )
+		sample = 32767;
+	else if ( sample < -32768 )
+		sample = -32768;
+	return sample;
+}
+#endif
+
+
+
 static ymsample	YM2149_NextSample_250 ( void )
 {
 #ifndef __LIBRETRO__
@@ -1424,6 +2109,10 @@ static ymsample	YM2149_NextSample_250 ( void )
 #else
 	// filters were mistakenly applied at the wrong frequency above
 	ymsample sample = 0;
+	// the FIR filter replaces both the resampling and the lowpass filter
+	if (YM2149_LPF_Filter == YM2149_LPF_FILTER_FIR && core_audio_filter)
+		return YM2149_Next_Resample_FIR();
+	YM_FIR_End = -1; // must start again when it resumes
 	switch (YM2149_Resample_Method)
 	{
 		case YM2149_RESAMPLE_METHOD_NEAREST:            sample = YM2149_Next_Resample_Nearest();            break;
@@ -1431,6 +2120,9 @@ static ymsample	YM2149_NextSample_250 ( void )
 		case YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N: sample = YM2149_Next_Resample_Weighted_Average_N(); break;
 		default: break;
 	}
+	// output filters only shape what is heard, their state is not part of the emulation
+	if (!core_audio_filter)
+		return sample;
 	switch (YM2149_LPF_Filter)
 	{
 		default:
@@ -1682,6 +2374,9 @@ void Sound_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&pos_fract_nearest, sizeof(pos_fract_nearest));
 	MemorySnapShot_Store(&pos_fract_weighted_2, sizeof(pos_fract_weighted_2));
 	MemorySnapShot_Store(&pos_fract_weighted_n, sizeof(pos_fract_weighted_n));
+#ifdef __LIBRETRO__
+	YM_FIR_End = -1; // rebuilt from the restored buffer
+#endif
 }
 
 
@@ -1852,6 +2547,7 @@ void Sound_Update(uint64_t CPU_Clock)
 		WAVFormat_Update(AudioMixBuffer, pos_write_prev, Samples_Nbr);
 
 #ifdef __LIBRETRO__
+	if (core_audio_enable)
 	{
 		int remain = Samples_Nbr;
 		int pos = pos_write_prev;
@@ -1862,8 +2558,8 @@ void Sound_Update(uint64_t CPU_Clock)
 			remain -= len;
 			pos = (pos + len) & AUDIOMIXBUFFER_SIZE_MASK;
 		}
-		nGeneratedSamples = 0;
 	}
+	nGeneratedSamples = 0;
 #endif
 
 }
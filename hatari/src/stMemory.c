@@ -17,6 +17,7 @@ const char STMemory_fileid[] = "Hatari stMemory.c";
 #include "memory.h"
 #include "memorySnapShot.h"
 #include "tos.h"
+#include "utils.h"
 #include "vdi.h"
 #include "m68000.h"
 #include "video.h"
@@ -53,6 +54,32 @@ static uint32_t	STMemory_MMU_Translate_Addr_STF ( uint32_t addr_logical , int RA
 static uint32_t	STMemory_MMU_Translate_Addr_STE ( uint32_t addr_logical , int RAM_Bank_Size , int MMU_Bank_Size );
 
 
+#ifdef __LIBRETRO__
+uint8_t STMemory_PageDirty[ STMEMORY_PAGE_COUNT + 1 ];	/* STMEMORY_DIRTY_xxx flags of each 4KB page of STRam[] */
+bool STMemory_SkipClear = false;		/* set while restoring a snapshot, RAM is replaced by the snapshot afterwards */
+
+extern bool core_savestate_delta;		/* incremental savestate requested by the core (run-ahead) */
+extern bool core_savestate_local;		/* savestate is only saved and restored by this instance (run-ahead, rewind) */
+extern bool bCaptureError;
+
+static uint8_t *STMemory_DeltaBase = NULL;	/* reference copy of ST RAM that incremental savestates are relative to */
+static uint32_t STMemory_DeltaBaseSize = 0;
+static uint32_t STMemory_DeltaGeneration = 0;	/* incremented each time the reference copy is replaced */
+static uint8_t STMemory_DeltaRestored[ STMEMORY_PAGE_COUNT ];
+static int STMemory_RewindPos = -1;		/* position of RAM in the last rewind savestate, -1 if none */
+static uint32_t STMemory_RewindSize = 0;
+
+/* The cartridge and TOS ROM area is only written while loading TOS at cold reset,
+ * which a snapshot restore also does, so savestates only need to store its hash.
+ * Savestates of this same instance skip the hash, because the TOS and cartridge
+ * are reloaded using the configuration restored from the savestate itself. */
+#define	STMEMORY_ROM_START	0xE00000
+#define	STMEMORY_ROM_END	0xFF0000	/* IO memory follows, it is always stored */
+static uint64_t STMemory_RomHash = 0;
+static bool STMemory_RomHashValid = false;
+#endif
+
+
 #define	DMA_READ_WORD_BUS_ERR	0x0000		/* This value is returned when reading a word using DMA (blitter, sound) */
 						/* in a region that would cause a bus error */
 						/* [NP] FIXME : for now we return a constant, but it should depend on the bus activity */
@@ -135,6 +162,9 @@ bool STMemory_SafeClear(uint32_t addr, unsigned int len)
 		if (addr + len < 0x1000000)
 		{
 			memset(&STRam[addr], 0, len);
+#ifdef __LIBRETRO__
+			STMemory_MarkDirtyRange(addr, len);
+#endif
 		}
 		else
 		{
@@ -174,6 +204,9 @@ bool STMemory_SafeCopy(uint32_t addr, uint8_t *src, unsigned int len, const char
 		if (addr + len < 0x1000000)
 		{
 			memcpy(&STRam[addr], src, len);
+#ifdef __LIBRETRO__
+			STMemory_MarkDirtyRange(addr, len);
+#endif
 		}
 		else
 		{
@@ -193,6 +226,237 @@ bool STMemory_SafeCopy(uint32_t addr, uint8_t *src, unsigned int len, const char
 }
 
 
+#ifdef __LIBRETRO__
+/**
+ * Mark the 4KB pages of STRam[] covering offset..offset+len-1 as modified.
+ */
+void STMemory_MarkDirtyRange ( uint32_t offset , uint32_t len )
+{
+	uint32_t first, last;
+
+	if ( len == 0 || offset >= 0x1000000 )
+		return;
+	first = offset >> STMEMORY_PAGE_SHIFT;
+	last = ( offset + len - 1 ) >> STMEMORY_PAGE_SHIFT;
+	if ( last > STMEMORY_PAGE_COUNT )
+		last = STMEMORY_PAGE_COUNT;
+	memset ( &STMemory_PageDirty[ first ] , STMEMORY_DIRTY_ALL , last - first + 1 );
+}
+
+/**
+ * Mark modified pages from a host pointer, ignored if it is not inside STRam[].
+ */
+void STMemory_MarkDirtyPointer ( const void *p , uint32_t len )
+{
+	const uint8_t *b = p;
+
+	if ( b >= STRam && b < STRam + 0x1000000 )
+		STMemory_MarkDirtyRange ( b - STRam , len );
+}
+
+/**
+ * Called after TOS and cartridge have been copied into the ROM area at cold reset.
+ * Any later change of the ROM area is seen through its dirty pages.
+ */
+void STMemory_RomLoaded ( void )
+{
+	memset ( &STMemory_PageDirty[ STMEMORY_ROM_START >> STMEMORY_PAGE_SHIFT ] , 0 ,
+		( STMEMORY_ROM_END - STMEMORY_ROM_START ) >> STMEMORY_PAGE_SHIFT );
+	STMemory_RomHashValid = false;
+}
+
+/**
+ * Return true if the ROM area was modified since it was loaded.
+ */
+static bool STMemory_RomModified ( void )
+{
+	uint32_t i;
+
+	for ( i = STMEMORY_ROM_START >> STMEMORY_PAGE_SHIFT ; i < ( STMEMORY_ROM_END >> STMEMORY_PAGE_SHIFT ) ; i++ )
+		if ( STMemory_PageDirty[ i ] )
+			return true;
+	return false;
+}
+
+/**
+ * Hash of the ROM area as it was loaded, computed once after each cold reset.
+ */
+static uint64_t STMemory_GetRomHash ( void )
+{
+	if ( !STMemory_RomHashValid )
+	{
+		STMemory_RomHash = hash64 ( &RomMem[ STMEMORY_ROM_START ] , STMEMORY_ROM_END - STMEMORY_ROM_START );
+		STMemory_RomHashValid = true;
+	}
+	return STMemory_RomHash;
+}
+
+/**
+ * Incremental savestate of ST RAM, used for run-ahead where the state is
+ * restored by the same running instance that saved it.
+ * Only the pages that differ from a reference copy of ST RAM are stored.
+ * The reference copy is taken once and never replaced while its size is
+ * unchanged, because the frontend may still restore any older state
+ * (e.g. preemptive frames), and all of them are relative to it.
+ */
+static bool STMemory_MemorySnapShot_DeltaUseful(void)
+{
+	uint32_t nPages = STRamEnd >> STMEMORY_PAGE_SHIFT;
+	uint32_t nCount, nLimit, i;
+
+	if (STMemory_DeltaBase == NULL || STMemory_DeltaBaseSize != STRamEnd)
+		return true;	/* a new reference copy will be taken, with no pages to store */
+
+	nCount = 0;
+	for (i = 0; i < nPages; i++)
+		nCount += STMemory_PageDirty[i] & STMEMORY_DIRTY_DELTA;
+	nLimit = (STRamEnd - 2 * sizeof(uint32_t)) / (sizeof(uint16_t) + STMEMORY_PAGE_SIZE);
+	if (nCount < nLimit)
+		return true;
+
+	/* pages can be marked without really differing (e.g. after a full restore), check them */
+	nCount = 0;
+	for (i = 0; i < nPages; i++)
+	{
+		if (STMemory_PageDirty[i] & STMEMORY_DIRTY_DELTA)
+		{
+			if (memcmp(STRam + (i << STMEMORY_PAGE_SHIFT), STMemory_DeltaBase + (i << STMEMORY_PAGE_SHIFT), STMEMORY_PAGE_SIZE))
+				++nCount;
+			else
+				STMemory_PageDirty[i] &= ~STMEMORY_DIRTY_DELTA;
+		}
+	}
+
+	/* when too much has changed, a full self-contained copy of RAM is smaller */
+	return nCount < nLimit;
+}
+
+static void STMemory_MemorySnapShot_Delta(bool bSave)
+{
+	uint32_t nPages = STRamEnd >> STMEMORY_PAGE_SHIFT;	/* RAM sizes are all multiples of the page size */
+	uint32_t nGeneration, nCount, i;
+	uint16_t nPage;
+
+	if (bSave)
+	{
+		/* take the reference copy, there can't be any state relative to it yet */
+		if (STMemory_DeltaBase == NULL || STMemory_DeltaBaseSize != STRamEnd)
+		{
+			free(STMemory_DeltaBase);
+			STMemory_DeltaBase = malloc(STRamEnd);
+			STMemory_DeltaBaseSize = STRamEnd;
+			if (STMemory_DeltaBase == NULL)
+			{
+				STMemory_DeltaBaseSize = 0;
+				core_error_msg("Out of memory for incremental savestate.");
+				bCaptureError = true;
+				return;
+			}
+			memcpy(STMemory_DeltaBase, STRam, STRamEnd);
+			for (i = 0; i < nPages; i++)
+				STMemory_PageDirty[i] &= ~STMEMORY_DIRTY_DELTA;
+			++STMemory_DeltaGeneration;
+		}
+
+		nCount = 0;
+		for (i = 0; i < nPages; i++)
+			nCount += STMemory_PageDirty[i] & STMEMORY_DIRTY_DELTA;
+
+		MemorySnapShot_Store(&STMemory_DeltaGeneration, sizeof(STMemory_DeltaGeneration));
+		MemorySnapShot_Store(&nCount, sizeof(nCount));
+		for (i = 0; i < nPages && nCount > 0; i++)
+		{
+			if (STMemory_PageDirty[i] & STMEMORY_DIRTY_DELTA)
+			{
+				nPage = i;
+				MemorySnapShot_Store(&nPage, sizeof(nPage));
+				MemorySnapShot_Store(STRam + (i << STMEMORY_PAGE_SHIFT), STMEMORY_PAGE_SIZE);
+				--nCount;
+			}
+		}
+	}
+	else
+	{
+		MemorySnapShot_Store(&nGeneration, sizeof(nGeneration));
+		MemorySnapShot_Store(&nCount, sizeof(nCount));
+		if (STMemory_DeltaBase == NULL || STMemory_DeltaBaseSize != STRamEnd || nGeneration != STMemory_DeltaGeneration || nCount > nPages)
+		{
+			core_error_msg("Incremental savestate does not match the current session.");
+			bCaptureError = true;
+			if (nCount <= nPages)
+				MemorySnapShot_Skip(nCount * (sizeof(nPage) + STMEMORY_PAGE_SIZE));
+			return;
+		}
+
+		memset(STMemory_DeltaRestored, 0, nPages);
+		for (i = 0; i < nCount; i++)
+		{
+			MemorySnapShot_Store(&nPage, sizeof(nPage));
+			if (nPage >= nPages)
+			{
+				core_error_msg("Incremental savestate page out of range.");
+				bCaptureError = true;
+				return;
+			}
+			MemorySnapShot_Store(STRam + (nPage << STMEMORY_PAGE_SHIFT), STMEMORY_PAGE_SIZE);
+			STMemory_DeltaRestored[nPage] = 1;
+			STMemory_PageDirty[nPage] = STMEMORY_DIRTY_ALL;
+		}
+
+		/* pages modified since then, but not part of the savestate, revert to the reference copy */
+		for (i = 0; i < nPages; i++)
+		{
+			if ((STMemory_PageDirty[i] & STMEMORY_DIRTY_DELTA) && !STMemory_DeltaRestored[i])
+			{
+				memcpy(STRam + (i << STMEMORY_PAGE_SHIFT), STMemory_DeltaBase + (i << STMEMORY_PAGE_SHIFT), STMEMORY_PAGE_SIZE);
+				STMemory_PageDirty[i] = STMEMORY_DIRTY_REWIND;
+			}
+		}
+	}
+}
+
+/**
+ * Rewind savestates store all of ST RAM, but the core keeps the last one it
+ * saved or restored, and marks the blocks of it that each step back changes.
+ * RAM then only differs from the savestate in the pages written since (dirty),
+ * or in the blocks the core changed, and only those pages are copied.
+ */
+static void STMemory_MemorySnapShot_Rewind(bool bSave)
+{
+	uint32_t nPages = STRamEnd >> STMEMORY_PAGE_SHIFT;
+	uint32_t nPos, i;
+	bool bPartial;
+
+	bPartial = !bSave && snapshot_buffer && snapshot_pos == STMemory_RewindPos && STRamEnd == STMemory_RewindSize
+		&& snapshot_pos + (int)STRamEnd <= snapshot_size;
+	STMemory_RewindPos = snapshot_pos;
+	STMemory_RewindSize = STRamEnd;
+	if (!bPartial)
+	{
+		MemorySnapShot_Store(STRam, STRamEnd);
+		if (!bSave)
+			STMemory_MarkDirtyRange(0, STRamEnd);
+		for (i = 0; i < nPages; i++)
+			STMemory_PageDirty[i] &= ~STMEMORY_DIRTY_REWIND;
+		return;
+	}
+
+	nPos = snapshot_pos;
+	for (i = 0; i < nPages; i++, nPos += STMEMORY_PAGE_SIZE)
+	{
+		if ((STMemory_PageDirty[i] & STMEMORY_DIRTY_REWIND) ||
+			core_rewind_changed[nPos >> CORE_REWIND_BLOCK_SHIFT] ||
+			core_rewind_changed[(nPos + STMEMORY_PAGE_SIZE - 1) >> CORE_REWIND_BLOCK_SHIFT])
+		{
+			memcpy(STRam + (i << STMEMORY_PAGE_SHIFT), snapshot_buffer + nPos, STMEMORY_PAGE_SIZE);
+			STMemory_PageDirty[i] = STMEMORY_DIRTY_DELTA;
+		}
+	}
+	MemorySnapShot_Skip(STRamEnd);
+}
+#endif
+
+
 /**
  * Save/Restore snapshot of RAM / ROM variables
  * ('MemorySnapShot_Store' handles type)
@@ -209,10 +473,62 @@ void STMemory_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&MMU_Conf_Expected, sizeof(MMU_Conf_Expected));
 
 	/* Only save/restore area of memory machine is set to, eg 1Mb */
+#ifndef __LIBRETRO__
 	MemorySnapShot_Store(STRam, STRamEnd);
+#else
+	{
+		uint8_t bDelta = (bSave && core_savestate_delta && STMemory_MemorySnapShot_DeltaUseful()) ? 1 : 0;
+		MemorySnapShot_Store(&bDelta, sizeof(bDelta));
+		if (bDelta)
+		{
+			STMemory_MemorySnapShot_Delta(bSave);
+		}
+		else if (core_savestate_rewind)
+		{
+			STMemory_MemorySnapShot_Rewind(bSave);
+		}
+		else
+		{
+			MemorySnapShot_Store(STRam, STRamEnd);
+			/* all of RAM was replaced, it no longer matches the reference copy */
+			if (!bSave)
+				STMemory_MarkDirtyRange(0, STRamEnd);
+		}
+	}
+#endif
 
 	/* And Cart/TOS/Hardware area */
+#ifndef __LIBRETRO__
 	MemorySnapShot_Store(&RomMem[0xE00000], 0x200000);
+#else
+	{
+		/* Cart/TOS is reloaded by the cold reset before restoring, store only its hash when unmodified */
+		uint64_t nRomHash = 0;
+		uint8_t bRomStored = 0;
+
+		if (bSave)
+		{
+			/* the size query reserves room for a modified ROM area */
+			bRomStored = (core_snapshot_size_query || STMemory_RomModified()) ? 1 : 0;
+			if (!bRomStored && !core_savestate_local)
+				nRomHash = STMemory_GetRomHash();
+		}
+		MemorySnapShot_Store(&bRomStored, sizeof(bRomStored));
+		MemorySnapShot_Store(&nRomHash, sizeof(nRomHash));
+		if (bRomStored)
+		{
+			MemorySnapShot_Store(&RomMem[STMEMORY_ROM_START], STMEMORY_ROM_END - STMEMORY_ROM_START);
+			if (!bSave)
+				STMemory_MarkDirtyRange(STMEMORY_ROM_START, STMEMORY_ROM_END - STMEMORY_ROM_START);
+		}
+		else if (!bSave && !core_savestate_local && (STMemory_RomModified() || nRomHash != STMemory_GetRomHash()))
+		{
+			core_error_msg("Savestate TOS or cartridge does not match the current one.");
+			bCaptureError = true;
+		}
+		MemorySnapShot_Store(&RomMem[STMEMORY_ROM_END], 0x1000000 - STMEMORY_ROM_END);
+	}
+#endif
 
 	/* Save/restore content of TT RAM if TTRamSize_KB != 0 */
 	if ( ConfigureParams.Memory.TTRamSize_KB > 0 )
@@ -238,6 +554,13 @@ void STMemory_SetDefaultConfig(void)
 	uint8_t MMU_Conf_Force;
 	uint8_t nFalcSysCntrl;
 
+#ifdef __LIBRETRO__
+	if (STMemory_SkipClear)
+	{
+		/* RAM will be replaced by the snapshot, don't waste time clearing it */
+	}
+	else
+#endif
 	if (bRamTosImage)
 	{
 		/* Clear ST-RAM, excluding the RAM TOS image */
@@ -632,6 +955,10 @@ void	STMemory_Write ( uint32_t addr , uint32_t val , int size )
 	/* We modify the memory, so we flush the instr/data caches if needed */
 	M68000_Flush_All_Caches ( addr , size );
 	
+#ifdef __LIBRETRO__
+	STMemory_MarkDirtyPointer ( p , size );
+#endif
+
 	if ( size == 4 )
 		do_put_mem_long ( p , val );
 	else if ( size == 2 )
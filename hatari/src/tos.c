@@ -1257,6 +1257,9 @@ int TOS_InitImage(void)
 	pTosFile = NULL;
 #ifdef __LIBRETRO__
 	}
+	STMemory_MarkDirtyRange(0xe00000, 0x200000);
+	if (bRamTosImage)
+		STMemory_MarkDirtyRange(TosAddress, TosSize);
 #endif
 
 	Log_Printf(LOG_DEBUG, "Loaded TOS version %i.%c%c, starting at $%x, "
@@ -11,6 +11,9 @@
  */
 const char Utils_fileid[] = "Hatari utils.c";
 
+#include <string.h>
+#include <SDL_endian.h>
+
 #include "utils.h"
 
 
@@ -99,6 +102,43 @@ void	crc16_add_byte ( uint16_t *crc , uint8_t c )
 }
 
 
+#ifdef __LIBRETRO__
+/************************************************************************/
+/* Function used to compute a 64 bit hash of a block of bytes, used	*/
+/* to identify unmodified contents in savestates.			*/
+/* It uses 4 independent lanes of 64 bit words to be fast on large	*/
+/* blocks. The result doesn't depend on the host endianness.		*/
+/************************************************************************/
+
+#define	HASH64_INIT	0xcbf29ce484222325ULL
+#define	HASH64_PRIME	0x100000001b3ULL
+
+static inline uint64_t	hash64_word ( const uint8_t *p )
+{
+	uint64_t	w;
+
+	memcpy ( &w , p , sizeof ( w ) );			/* unaligned safe, compiles to a single load */
+	return SDL_SwapBE64 ( w );
+}
+
+uint64_t	hash64 ( const uint8_t *p , uint32_t len )
+{
+	uint64_t	h0 = HASH64_INIT , h1 = HASH64_INIT + 1 , h2 = HASH64_INIT + 2 , h3 = HASH64_INIT + 3;
+	uint32_t	i;
+
+	for ( i=0 ; i+32 <= len ; i+=32 )
+	{
+		h0 = ( h0 ^ hash64_word ( p+i ) ) * HASH64_PRIME;
+		h1 = ( h1 ^ hash64_word ( p+i+8 ) ) * HASH64_PRIME;
+		h2 = ( h2 ^ hash64_word ( p+i+16 ) ) * HASH64_PRIME;
+		h3 = ( h3 ^ hash64_word ( p+i+24 ) ) * HASH64_PRIME;
+	}
+	for ( ; i<len ; i++ )
+		h0 = ( h0 ^ p[ i ] ) * HASH64_PRIME;
+
+	return h0 ^ ( h1 * 3 ) ^ ( h2 * 5 ) ^ ( h3 * 7 ) ^ len;
+}
+#endif
 
 
 /************************************************************************/